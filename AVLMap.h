@@ -1,15 +1,18 @@
-#ifndef TREEMAP_H
-#define TREEMAP_H
+#ifndef AVLMAP_H
+#define AVLMAP_H
 #include "AVLTree.h"
 /**
  * A class that implements the Map.h interface.
  * This implements the Map ADT using an AVL tree. 
  * T1 is the type of the key T2 is the type of the 
- * value in a (key, value) pair.
+ * value in a (key, value) pair. Alloc is the
+ * allocator of the tree nodes; see SlabAllocator.h
  */
-template <typename T1, typename T2>
+template <typename T1, typename T2, template <typename> class Alloc = SlabAllocator>
 class AVLMap : public Map<T1, T2>
-{
+{	//Typedef to access Map's KeyValue pair
+	//Necessary only in g++
+	typedef typename Map<T1, T2>::KeyValue KeyValue;
 public:
 
 	/**
@@ -27,47 +30,126 @@ public:
 		catch(int error)
 		{	//Check the exception error code
 			if(error == avl.ELE_DNE)
-				throw ELE_DNE;
+				throw this->ELE_DNE;
 		}
 	}
 
 	/**
-	* Attempts to find the corresponding value
-	* for a given key. The int ELE_DNE is thrown
-	* if the key is not in the map
+	* Finds the corresponding value for a given
+	* key without throwing
 	* @param k Is the key to search for
-	* @return The value corresponding to k
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
 	*/
-	T2& Find(const T1& k) const
-	{	//Attempt to find the element
-		KeyValue kv(k);
-		try
-		{
-			kv = avl.Find(kv);
-		}
-		catch(int error)
-		{	//Check the exception error code
-			if(error == avl.ELE_DNE)
-				throw ELE_DNE;
-		}
-		return kv.val;
+	T2* TryFind(const T1& k) const
+	{
+		KeyValue* kv = avl.TryFind(KeyValue(k));
+		return kv == NULL ? NULL : &kv->val;
 	}
 
 	//Overloaded assignment operator
 	AVLMap& operator=(const AVLMap& tm)
 	{	//Self-assignment check already handled by AVLTree
-		avl = tmp.avl;
+		avl = tm.avl;
 		return *this;
 	}
 
 	/**
-	* Adds a (key, value) pair to the map
+	* Adds a (key, value) pair to the map. The int
+	* DUP_ELE is thrown if the key is already in the map
 	* @param k Is the key
 	* @param v Is the value
 	*/
 	void Put(const T1& k, const T2& v)
 	{	//Add the element to the AVLTree
-		avl.Insert(KeyValue(k, v));
+		bool found;
+		avl.FindOrInsert(KeyValue(k, v), found);
+		if(found)
+			throw this->DUP_ELE;
+	}
+
+	/**
+	* Finds the corresponding value for a given key.
+	* If the key is not in the map the pair (k, T2())
+	* is added first. The tree is descended once
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	T2& FindOrInsert(const T1& k)
+	{
+		bool found;
+		return avl.FindOrInsert(KeyValue(k, T2()), found).val;
+	}
+
+	/**
+	* Sets the value for a given key, adding the
+	* (key, value) pair if the key is not in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	void Upsert(const T1& k, const T2& v)
+	{
+		bool found;
+		KeyValue& kv = avl.FindOrInsert(KeyValue(k, v), found);
+		if(found)
+			kv.val = v;
+	}
+
+	/**
+	* Finds the first pair with a key not less than k
+	* @param k Is the key to search for
+	* @param key Output variable of the key of the pair
+	* @return A pointer to the value of the pair or NULL
+	* if every key is less than k
+	*/
+	T2* LowerBound(const T1& k, T1& key) const
+	{
+		KeyValue* kv = avl.LowerBound(KeyValue(k));
+		if(kv == NULL)
+			return NULL;
+		key = kv->key;
+		return &kv->val;
+	}
+
+	/**
+	* Finds the first pair with a key greater than k
+	* @param k Is the key to search for
+	* @param key Output variable of the key of the pair
+	* @return A pointer to the value of the pair or NULL
+	* if no key is greater than k
+	*/
+	T2* UpperBound(const T1& k, T1& key) const
+	{
+		KeyValue* kv = avl.UpperBound(KeyValue(k));
+		if(kv == NULL)
+			return NULL;
+		key = kv->key;
+		return &kv->val;
+	}
+
+	/**
+	* Calls f(key, val) for every pair with lo <= key < hi
+	* in key order
+	* @param lo Is the smallest key of the range
+	* @param hi Is the end of the range; not included
+	* @param f Is the function to call
+	* @return The number of pairs visited
+	*/
+	template <typename F>
+	unsigned int Range(const T1& lo, const T1& hi, F f) const
+	{
+		return avl.Range(KeyValue(lo), KeyValue(hi), Visit<F>(f));
+	}
+
+	/**
+	* Calls f(key, val) for every pair in key order
+	* @param f Is the function to call
+	* @return The number of pairs visited
+	*/
+	template <typename F>
+	unsigned int ForEach(F f) const
+	{
+		return avl.ForEach(Visit<F>(f));
 	}
 
 	/**
@@ -78,6 +160,12 @@ public:
 	{	//Return the size of the underlying list
 		return avl.Size();
 	}
+
+	//Returns the number of calls to the system allocator
+	size_t SystemAllocs() const
+	{
+		return avl.SystemAllocs();
+	}
 	
 	//Already handled by AVLTree class
 	AVLMap() { }
@@ -89,7 +177,18 @@ public:
 	virtual ~AVLMap() { }
 	  
 private:
+	//Passes the key and value of a pair to f
+	template <typename F>
+	class Visit
+	{
+	public:
+		Visit(F& fn) : f(fn) { }
+		void operator()(KeyValue& kv) { f(kv.key, kv.val); }
+	private:
+		F& f;
+	};
+
 	//AVLTree
-	AVLTree<KeyValue> avl;
+	AVLTree<KeyValue, Alloc> avl;
 };
 #endif
\ No newline at end of file
@@ -1,10 +1,18 @@
 #ifndef AVLTREE_H
 #define AVLTREE_H
-template <typename T>
+#include <algorithm>
+#include <type_traits>
+#include "SlabAllocator.h"
+/**
+ * An AVL tree of values of type T. Nodes come from an
+ * allocator of type Alloc; see SlabAllocator.h
+ */
+template <typename T, template <typename> class Alloc = SlabAllocator>
 class AVLTree
 {
 public:
 	const static int ELE_DNE = -123;
+	const static int DUP_ELE = -124;
 
 	//Default constructor
 	AVLTree() 
@@ -18,7 +26,7 @@ public:
 	{
 		root = nullptr;
 		n = 0;
-		Traverse(bst.root, &AVLTree<T>::AddNode);
+		Traverse(bst.root, &AVLTree::AddNode);
 	}
 
 	//Virtual Destructor
@@ -29,11 +37,15 @@ public:
 
 	/**
 	 * Destroys the tree freeing all dynamic memory.
-	 * After calling the (now empty) tree is ready to be used
+	 * After calling the (now empty) tree is ready to be used.
+	 * Nodes without destructors are not visited if the
+	 * allocator can release them all at once
 	 */
 	void Destroy()
 	{
-		Traverse(root, &AVLTree<T>::DestroyNode); 
+		if(!Alloc<Node>::BULK || !std::is_trivially_destructible<Node>::value)
+			Traverse(root, &AVLTree::DestroyNode);
+		alloc.Clear();
 		root = nullptr;
 		n = 0;
 	}
@@ -51,16 +63,107 @@ public:
 	}	
 
 	/**
-	 * Inserts a value to the AVL tree
+	 * Finds a value in the AVL tree without throwing
+	 * @param val Is the value to find
+	 * @return A pointer to the stored value or nullptr
+	 */
+	T* TryFind(const T& val) const
+	{
+		Node* ret = *(Find(&root, val).c);
+		return ret == nullptr ? nullptr : &ret->val;
+	}
+
+	/**
+	 * Finds the first value in order not less than val
+	 * @param val Is the value to search for
+	 * @return A pointer to the stored value or nullptr
+	 */
+	T* LowerBound(const T& val) const
+	{
+		Node* ret = Lower(val);
+		return ret == nullptr ? nullptr : &ret->val;
+	}
+
+	/**
+	 * Finds the first value in order greater than val
+	 * @param val Is the value to search for
+	 * @return A pointer to the stored value or nullptr
+	 */
+	T* UpperBound(const T& val) const
+	{
+		Node* ret = Lower(val);
+		if(ret != nullptr && ret->val == val)
+			ret = Next(ret);
+		return ret == nullptr ? nullptr : &ret->val;
+	}
+
+	/**
+	 * Calls f(v) for every stored value with lo <= v < hi
+	 * in order. The walk follows the up links from each
+	 * node to its successor
+	 * @param lo Is the smallest value of the range
+	 * @param hi Is the end of the range; not included
+	 * @param f Is the function to call
+	 * @return The number of values visited
+	 */
+	template <typename F>
+	unsigned int Range(const T& lo, const T& hi, F f) const
+	{
+		unsigned int c = 0;
+		for(Node* p = Lower(lo); p != nullptr && p->val < hi; p = Next(p), ++c)
+			f(p->val);
+		return c;
+	}
+
+	/**
+	 * Calls f(v) for every stored value in order
+	 * @param f Is the function to call
+	 * @return The number of values visited
+	 */
+	template <typename F>
+	unsigned int ForEach(F f) const
+	{
+		unsigned int c = 0;
+		for(Node* p = root == nullptr ? nullptr : FindMinNode(root); p != nullptr; p = Next(p), ++c)
+			f(p->val);
+		return c;
+	}
+
+	/**
+	 * Inserts a value to the AVL tree. Throws
+	 * DUP_ELE if an equal value is in the tree
 	 * @param val Is the value to insert
 	 */
 	void Insert(const T& val) 
+	{
+		bool found;
+		FindOrInsert(val, found);
+		if(found)
+			throw DUP_ELE;
+	}
+
+	/**
+	 * Finds a value in the AVL tree, inserting it if
+	 * it is not found. The tree is descended once;
+	 * rotations move nodes, not values
+	 * @param val Is the value to find or insert
+	 * @param found Output variable; true if an equal
+	 * value was already in the tree
+	 * @return The value stored in the tree
+	 */
+	T& FindOrInsert(const T& val, bool& found)
 	{ 	//Find the node (remove const qualifier)
 		Link l = Find(&root, val);
 		Node** node = const_cast<Node**>(l.c);
-		(*node) = new Node(val, l.p == nullptr ? nullptr : *(l.p));
+		found = (*node) != nullptr;
+		if(found)
+			return (*node)->val;
+		Node* nn = alloc.New(val, l.p == nullptr ? nullptr : *(l.p));
+		(*node) = nn;
 		++n;
-		Balance(*node);
+		//A new leaf has the right height already
+		Balance(nn->up);
+		return nn->val;
 	}
 
 	/**
@@ -73,7 +176,7 @@ public:
 		if(this == &bst)
 			return *this;
 		Destroy();
-		Traverse(bst.root, &AVLTree<T>::AddNode);
+		Traverse(bst.root, &AVLTree::AddNode);
 		return *this;
 	}
 	
@@ -95,6 +198,12 @@ public:
 		return n;
 	}
 
+	//Returns the number of calls to the system allocator
+	size_t SystemAllocs() const
+	{
+		return alloc.SystemAllocs();
+	}
+
 private:
 	/**
 	 * This class represents a node in the search tree
@@ -102,13 +211,13 @@ private:
 	class Node
 	{
 	public:
-		Node() { left = right = up = nullptr; hs = 0; }
-		Node(const T& v, Node* u = nullptr) { left = right = nullptr; val = v; up = u; hs = 0;}
+		Node() { left = right = up = nullptr; ht = 0; }
+		Node(const T& v, Node* u = nullptr) { left = right = nullptr; val = v; up = u; ht = 0;}
 		Node* left;
 		Node* right;
 		Node* up;
-		//The height score
-		int hs;
+		//The height of the subtree rooted here; 0 for a leaf
+		int ht;
 		T val;
 	};
 
@@ -134,31 +243,38 @@ private:
 	/**
 	 * This function performs the balance
 	 * routing for an AVL tree starting at
-	 * node n and traveling up the tree to
-	 * the root
+	 * node n and traveling up the tree.
+	 * It stops early once a balanced node
+	 * keeps its height, as nothing above
+	 * it can change
 	 * @param n Is the node to start at
 	 */
 	void Balance(Node* n)
 	{
 		while(n != nullptr)
 		{	//Loop until the root is reached
-			n->hs = HeightScore(n);
+			int old = n->ht;
+			SetHeight(n);
+			int hs = HeightScore(n);
 			//Imbalance to left
-			if(n->hs == 2)
+			if(hs == 2)
 			{	//Left-right
-				if(n->left->hs == -1)
+				if(HeightScore(n->left) == -1)
 					RotLR(GetParentPtr(n));
 				//Left-left
 				n = RotLL(GetParentPtr(n));
 			}
 			//Imbalance to right
-			else if(n->hs == -2)
+			else if(hs == -2)
 			{	//Right-left
-				if(n->right->hs == 1)
+				if(HeightScore(n->right) == 1)
 					RotRL(GetParentPtr(n));
 				//Right-right
 				n = RotRR(GetParentPtr(n));
-			} //Loop done; one level up
+			}
+			else if(n->ht == old)
+				return;
+			//Loop done; one level up
 			n = n->up;
 		}
 	}
@@ -168,7 +284,7 @@ private:
 	 */
 	void DestroyNode(Node* ptr)
 	{
-		delete ptr;
+		alloc.Delete(ptr);
 	}
 
 	/**
@@ -190,8 +306,45 @@ private:
 		}
 	}
 
+	//Finds the first node in order not less than val
+	Node* Lower(const T& val) const
+	{
+		Node* ret = nullptr;
+		Node* ptr = root;
+		while(ptr != nullptr)
+		{
+			if(ptr->val < val)
+				ptr = ptr->right;
+			else
+			{
+				ret = ptr;
+				ptr = ptr->left;
+			}
+		}
+		return ret;
+	}
+
+	/**
+	 * Finds the next node in order: the minimum of the
+	 * right subtree or else the first ancestor reached
+	 * from a left child
+	 */
+	static Node* Next(Node* ptr)
+	{
+		if(ptr->right != nullptr)
+		{
+			ptr = ptr->right;
+			while(ptr->left)
+				ptr = ptr->left;
+			return ptr;
+		}
+		while(ptr->up != nullptr && ptr->up->right == ptr)
+			ptr = ptr->up;
+		return ptr->up;
+	}
+
 	//Finds the minimum valued node from  a given root
-	Node* FindMinNode(Node* ptr)
+	static Node* FindMinNode(Node* ptr)
 	{	//Proceed down left subtree
 		while(ptr->left)
 			ptr = ptr->left;
@@ -213,17 +366,24 @@ private:
 	}
 
 	//Returns the height of the subtree rooted
-	//At node n
-	int Height(Node* n)
+	//At node n; stored in the node
+	static int Height(const Node* n)
 	{
 		if(n == nullptr)
 			return -1;
-		return 1 + max(Height(n->left), Height(n->right));
+		return n->ht;
+	}
+
+	//Recomputes the height of node n from
+	//the heights of its children
+	static void SetHeight(Node* n)
+	{
+		n->ht = 1 + std::max(Height(n->left), Height(n->right));
 	}
 
 	//Compute the height score of a node
 	//for an AVL tree: height(left) - height(right)
-	int HeightScore(Node* n)
+	static int HeightScore(const Node* n)
 	{
 		if(n == nullptr)
 			return 0;
@@ -240,7 +400,7 @@ private:
 	{	//Find the node; remove const qualifier
 		Node** node = const_cast<Node**>(Find(&ptr, val).c);
 		//If node is null the value to remove dne
-		if(node == nullptr)
+		if(*node == nullptr)
 			throw ELE_DNE;
 		//At the node to remove
 		Node* tempPtr = nullptr;
@@ -258,7 +418,7 @@ private:
 			tempPtr = (*node);
 			(*node)->right->up = (*node)->up;
 			(*node) = (*node)->right;
-			delete tempPtr;
+			alloc.Delete(tempPtr);
 			Balance((*node)->up);
 		}
 		//Node only has left subtree
@@ -267,14 +427,14 @@ private:
 			tempPtr = (*node);
 			(*node)->left->up = (*node)->up;
 			(*node) = (*node)->left;
-			delete tempPtr;
+			alloc.Delete(tempPtr);
 			Balance((*node)->up);
 		}
 		//Node is external
 		else
 		{
 			tempPtr = (*node)->up;
-			delete (*node);
+			alloc.Delete(*node);
 			(*node) = nullptr;
 			Balance(tempPtr);
 		}
@@ -294,6 +454,9 @@ private:
 		three->right = B;
 		if(B)
 			B->up = three;
+		//Fix heights from the bottom up
+		SetHeight(three);
+		SetHeight(four);
 	}
 
 	//AVL Right-Left rotation
@@ -310,6 +473,9 @@ private:
 		five->left = C;
 		if(C)
 			C->up = five;
+		//Fix heights from the bottom up
+		SetHeight(five);
+		SetHeight(four);
 	}
 
 	//AVL Left-Left rotation
@@ -317,7 +483,6 @@ private:
 	{
 		Node *five = (*n);
 		Node *four = five->left;
-		Node *three = four->left;
 		Node* C = four->right;
 		(*n) = four;
 		four->up = five->up;
@@ -326,10 +491,9 @@ private:
 		five->left = C;
 		if(C)
 			C->up = five;
-		//Fix balance factors
-		three->hs = HeightScore(three);
-		five->hs = HeightScore(five);
-		four->hs = HeightScore(four);
+		//Fix heights; the subtree of three is unchanged
+		SetHeight(five);
+		SetHeight(four);
 		return four;
 	}
 
@@ -338,7 +502,6 @@ private:
 	{
 		Node *three = (*n);
 		Node *four = three->right;
-		Node *five = four->right;
 		Node* B = four->left;
 		(*n) = four;
 		four->up = three->up;
@@ -347,10 +510,9 @@ private:
 		three->right = B;
 		if(B)
 			B->up = three;
-		//Fix balance factors
-		three->hs = HeightScore(three);
-		five->hs = HeightScore(five);
-		four->hs = HeightScore(four);
+		//Fix heights; the subtree of five is unchanged
+		SetHeight(three);
+		SetHeight(four);
 		return four;
 	}
 
@@ -377,5 +539,7 @@ private:
 	//Data members
 	Node* root;
 	unsigned int n;
+	//Allocates the nodes
+	Alloc<Node> alloc;
 };
 #endif
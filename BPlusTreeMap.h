@@ -0,0 +1,684 @@
+#ifndef BPLUSTREEMAP_H
+#define BPLUSTREEMAP_H
+#include <type_traits>
+#include "Map.h"
+#include "KaryNode.h"
+#include "SlabAllocator.h"
+
+/**
+ * An ordered map stored in a B+tree. The keys of a node are the
+ * B keys of a KaryNode, which fill a 64 byte cache line, so the
+ * child to descend into is found with one SIMD compare (see
+ * KaryNode.h) and a lookup reads about one line of keys per level
+ * instead of one node per level of a binary tree. Inner nodes
+ * hold up to B keys and B + 1 children: key i is not less than
+ * every key below child i and is less than every key below child
+ * i + 1. The pairs are in the leaves, which are linked in key
+ * order so a range scan walks the leaves without climbing back up
+ * the tree. Every node but the root is at least half full; Erase
+ * borrows from or merges with a sibling to keep them so. Unused
+ * key slots repeat the largest key of their node so they never
+ * count as less than a key that belongs in the node. Nodes are
+ * aligned to cache lines and come from SlabAllocators.
+ */
+template <typename T1, typename T2>
+class BPlusTreeMap : public Map<T1, T2>
+{
+public:
+	/**
+	* Attempts to erase the (key, value) pair
+	* with key  = k. The int ELE_DNE is thrown
+	* if the key is not in the map
+	* @param k Is the key of the pair to erase
+	*/
+	virtual void Erase(const T1& k)
+	{
+		Inner* path[MAX_HEIGHT];
+		unsigned int idx[MAX_HEIGHT];
+		Leaf* leaf = Descend(k, path, idx);
+		unsigned int r = Rank(leaf, k);
+		if(r == leaf->c || !(leaf->keys[r] == k))
+			throw this->ELE_DNE;
+		for(unsigned int i = r + 1; i < leaf->c; ++i)
+		{
+			leaf->keys[i - 1] = leaf->keys[i];
+			leaf->vals[i - 1] = leaf->vals[i];
+		}
+		--leaf->c;
+		--n;
+		Shrink(leaf, path, idx);
+	}
+
+	/**
+	* Finds the corresponding value for a given
+	* key without throwing
+	* @param k Is the key to search for
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
+	*/
+	virtual T2* TryFind(const T1& k) const
+	{
+		Leaf* leaf = FindLeaf(k);
+		unsigned int r = Rank(leaf, k);
+		return r < leaf->c && leaf->keys[r] == k ? &leaf->vals[r] : NULL;
+	}
+
+	//Create an empty map
+	BPlusTreeMap()
+	{
+		Init();
+	}
+
+	//Copy constructor
+	BPlusTreeMap(const BPlusTreeMap& bm)
+	{
+		Init();
+		Copy(bm);
+	}
+
+	//Destructor
+	virtual ~BPlusTreeMap()
+	{
+		Free();
+	}
+
+	//Overloaded assignment operator
+	BPlusTreeMap& operator=(const BPlusTreeMap& bm)
+	{
+		Copy(bm);
+		return *this;
+	}
+
+	/**
+	* Adds a (key, value) pair to the map. The int
+	* DUP_ELE is thrown if the key is already in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Put(const T1& k, const T2& v)
+	{
+		bool found;
+		Insert(k, v, found);
+		if(found)
+			throw this->DUP_ELE;
+	}
+
+	/**
+	* Finds the corresponding value for a given key.
+	* If the key is not in the map the pair (k, T2())
+	* is added first. The tree is descended once
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	virtual T2& FindOrInsert(const T1& k)
+	{
+		bool found;
+		return Insert(k, T2(), found);
+	}
+
+	/**
+	* Sets the value for a given key, adding the
+	* (key, value) pair if the key is not in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Upsert(const T1& k, const T2& v)
+	{
+		bool found;
+		T2& val = Insert(k, v, found);
+		if(found)
+			val = v;
+	}
+
+	/**
+	* Finds the first pair with a key not less than k
+	* @param k Is the key to search for
+	* @param key Output variable of the key of the pair
+	* @return A pointer to the value of the pair or NULL
+	* if every key is less than k
+	*/
+	T2* LowerBound(const T1& k, T1& key) const
+	{
+		Leaf* leaf = FindLeaf(k);
+		return At(leaf, Rank(leaf, k), key);
+	}
+
+	/**
+	* Finds the first pair with a key greater than k
+	* @param k Is the key to search for
+	* @param key Output variable of the key of the pair
+	* @return A pointer to the value of the pair or NULL
+	* if no key is greater than k
+	*/
+	T2* UpperBound(const T1& k, T1& key) const
+	{
+		Leaf* leaf = FindLeaf(k);
+		unsigned int r = Rank(leaf, k);
+		if(r < leaf->c && leaf->keys[r] == k)
+			++r;
+		return At(leaf, r, key);
+	}
+
+	/**
+	* Calls f(key, val) for every pair with lo <= key < hi
+	* in key order
+	* @param lo Is the smallest key of the range
+	* @param hi Is the end of the range; not included
+	* @param f Is the function to call
+	* @return The number of pairs visited
+	*/
+	template <typename F>
+	unsigned int Range(const T1& lo, const T1& hi, F f) const
+	{
+		Leaf* leaf = FindLeaf(lo);
+		unsigned int c = 0;
+		for(unsigned int i = Rank(leaf, lo); leaf != NULL; leaf = leaf->next, i = 0)
+			for(; i < leaf->c; ++i, ++c)
+			{
+				if(!(leaf->keys[i] < hi))
+					return c;
+				f(leaf->keys[i], leaf->vals[i]);
+			}
+		return c;
+	}
+
+	/**
+	* Calls f(key, val) for every pair in key order
+	* @param f Is the function to call
+	* @return The number of pairs visited
+	*/
+	template <typename F>
+	unsigned int ForEach(F f) const
+	{
+		unsigned int c = 0;
+		for(Leaf* leaf = head; leaf != NULL; leaf = leaf->next)
+			for(unsigned int i = 0; i < leaf->c; ++i, ++c)
+				f(leaf->keys[i], leaf->vals[i]);
+		return c;
+	}
+
+	/**
+	* Returns the number of elements in the Map
+	* @return: Number of elements in map object
+	*/
+	virtual unsigned int Size() const
+	{
+		return n;
+	}
+
+	//Returns the number of levels including the leaves
+	unsigned int Height() const
+	{
+		return height + 1;
+	}
+
+private:
+	//Number of keys per node
+	const static unsigned int B = KaryNode<T1>::B;
+	//Fewest keys in a node other than the root
+	const static unsigned int MIN_KEYS = B / 2;
+	//Largest number of inner levels; half full nodes of
+	//two keys reach it only past 2^32 keys
+	const static unsigned int MAX_HEIGHT = 40;
+
+	/**
+	 * The part shared by inner nodes and leaves: the keys
+	 * fill the first cache line, followed by their count
+	 */
+	class alignas(64) Node
+	{
+	public:
+		Node() : c(0) { }
+		T1 keys[B];
+		unsigned int c;
+	};
+
+	//A leaf holds the pairs and the next leaf in key order
+	class Leaf : public Node
+	{
+	public:
+		Leaf() : next(NULL) { }
+		Leaf* next;
+		T2 vals[B];
+	};
+
+	//An inner node holds c + 1 children
+	class Inner : public Node
+	{
+	public:
+		Node* kids[B + 1];
+	};
+
+	/**
+	 * The number of keys of a node less than k; the
+	 * child to descend into or the position of k in a leaf
+	 */
+	static unsigned int Rank(const Node* x, const T1& k)
+	{
+		unsigned int r = KaryNode<T1>::Rank(x->keys, k);
+		return r < x->c ? r : x->c;
+	}
+
+	//Fills the unused key slots of a node with its largest key
+	static void Pad(Node* x)
+	{
+		for(unsigned int i = x->c; i < B && x->c > 0; ++i)
+			x->keys[i] = x->keys[x->c - 1];
+	}
+
+	//The leaf that holds k if k is in the map
+	Leaf* FindLeaf(const T1& k) const
+	{
+		Node* x = root;
+		for(unsigned int l = 0; l < height; ++l)
+			x = static_cast<Inner*>(x)->kids[Rank(x, k)];
+		return static_cast<Leaf*>(x);
+	}
+
+	/**
+	 * Finds the leaf that holds k if k is in the map
+	 * @param path Output variable of the inner nodes
+	 * passed from the root down
+	 * @param idx Output variable of the child taken
+	 * at each of them
+	 */
+	Leaf* Descend(const T1& k, Inner** path, unsigned int* idx) const
+	{
+		Node* x = root;
+		for(unsigned int l = 0; l < height; ++l)
+		{
+			path[l] = static_cast<Inner*>(x);
+			idx[l] = Rank(x, k);
+			x = path[l]->kids[idx[l]];
+		}
+		return static_cast<Leaf*>(x);
+	}
+
+	/**
+	 * The pair at position i of a leaf; the first pair of
+	 * the next leaf if i is past the last one
+	 * @return A pointer to the value or NULL if there
+	 * are no more pairs
+	 */
+	static T2* At(Leaf* leaf, unsigned int i, T1& key)
+	{
+		if(i == leaf->c)
+		{	//Leaves other than the root are never empty
+			leaf = leaf->next;
+			i = 0;
+		}
+		if(leaf == NULL)
+			return NULL;
+		key = leaf->keys[i];
+		return &leaf->vals[i];
+	}
+
+	/**
+	 * Finds the pair of a key, adding (k, v) if it is
+	 * not in the map. A full leaf is split in two and
+	 * the new separator is added to the parents, which
+	 * split in turn while they are full
+	 * @param found Output variable; true if the key
+	 * was in the map
+	 * @return The value of the key
+	 */
+	T2& Insert(const T1& k, const T2& v, bool& found)
+	{
+		Inner* path[MAX_HEIGHT];
+		unsigned int idx[MAX_HEIGHT];
+		Leaf* leaf = Descend(k, path, idx);
+		unsigned int r = Rank(leaf, k);
+		found = r < leaf->c && leaf->keys[r] == k;
+		if(found)
+			return leaf->vals[r];
+		++n;
+		if(leaf->c < B)
+			return Place(leaf, r, k, v);
+		//The left half keeps (B + 1) / 2 pairs
+		const unsigned int h = (B + 1) / 2;
+		Leaf* right = lalloc.New();
+		unsigned int first = r < h ? h - 1 : h;
+		for(unsigned int i = first; i < B; ++i)
+		{
+			right->keys[i - first] = leaf->keys[i];
+			right->vals[i - first] = leaf->vals[i];
+		}
+		right->c = B - first;
+		leaf->c = first;
+		right->next = leaf->next;
+		leaf->next = right;
+		T2& val = r < h ? Place(leaf, r, k, v) : Place(right, r - first, k, v);
+		Pad(leaf);
+		Pad(right);
+		Grow(path, idx, leaf->keys[leaf->c - 1], right);
+		return val;
+	}
+
+	//Inserts a pair at position r of a leaf that is not full
+	static T2& Place(Leaf* leaf, unsigned int r, const T1& k, const T2& v)
+	{
+		for(unsigned int i = leaf->c; i > r; --i)
+		{
+			leaf->keys[i] = leaf->keys[i - 1];
+			leaf->vals[i] = leaf->vals[i - 1];
+		}
+		leaf->keys[r] = k;
+		leaf->vals[r] = v;
+		++leaf->c;
+		Pad(leaf);
+		return leaf->vals[r];
+	}
+
+	/**
+	 * Adds a new right sibling of the node at the bottom
+	 * of the path to the inner nodes of the path. A new
+	 * root is made if every node on the path is full
+	 * @param sep A key not less than every key left of kid
+	 * and less than every key below kid
+	 * @param kid The new node
+	 */
+	void Grow(Inner** path, unsigned int* idx, T1 sep, Node* kid)
+	{
+		for(unsigned int l = height; l > 0; --l)
+		{
+			Inner* x = path[l - 1];
+			unsigned int i = idx[l - 1];
+			if(x->c < B)
+			{
+				for(unsigned int j = x->c; j > i; --j)
+				{
+					x->keys[j] = x->keys[j - 1];
+					x->kids[j + 1] = x->kids[j];
+				}
+				x->keys[i] = sep;
+				x->kids[i + 1] = kid;
+				++x->c;
+				Pad(x);
+				return;
+			}
+			//Split the B + 1 keys around the middle one
+			T1 keys[B + 1];
+			Node* kids[B + 2];
+			for(unsigned int j = 0, o = 0; j <= B; ++j)
+			{
+				if(j == i)
+				{
+					keys[j] = sep;
+					kids[j + 1] = kid;
+					o = 1;
+				}
+				else
+				{
+					keys[j] = x->keys[j - o];
+					kids[j + 1] = x->kids[j + 1 - o];
+				}
+			}
+			kids[0] = x->kids[0];
+			const unsigned int h = B / 2;
+			Inner* right = ialloc.New();
+			for(unsigned int j = 0; j < h; ++j)
+				x->keys[j] = keys[j];
+			for(unsigned int j = 0; j <= h; ++j)
+				x->kids[j] = kids[j];
+			x->c = h;
+			for(unsigned int j = h + 1; j <= B; ++j)
+				right->keys[j - h - 1] = keys[j];
+			for(unsigned int j = h + 1; j <= B + 1; ++j)
+				right->kids[j - h - 1] = kids[j];
+			right->c = B - h;
+			Pad(x);
+			Pad(right);
+			sep = keys[h];
+			kid = right;
+		}
+		Inner* nr = ialloc.New();
+		nr->keys[0] = sep;
+		nr->kids[0] = root;
+		nr->kids[1] = kid;
+		nr->c = 1;
+		Pad(nr);
+		root = nr;
+		++height;
+	}
+
+	/**
+	 * Restores the fill of the nodes on a path after a key
+	 * was removed from the node at its bottom. A node with
+	 * too few keys borrows one from a sibling that can spare
+	 * one or else is merged with it, which removes a key
+	 * from the parent. The root goes if it has one child
+	 * @param x The leaf at the bottom of the path
+	 */
+	void Shrink(Node* x, Inner** path, unsigned int* idx)
+	{
+		for(unsigned int l = height; l > 0; --l)
+		{
+			if(x->c >= MIN_KEYS)
+				break;
+			Inner* p = path[l - 1];
+			unsigned int i = idx[l - 1];
+			//Balance the children s and s + 1 of p
+			unsigned int s = i > 0 ? i - 1 : 0;
+			Node* a = p->kids[s];
+			Node* b = p->kids[s + 1];
+			Node* sib = i > 0 ? a : b;
+			bool leaf = l == height;
+			if(sib->c > MIN_KEYS)
+			{
+				if(leaf)
+					Borrow(static_cast<Leaf*>(a), static_cast<Leaf*>(b), p, s, sib == a);
+				else
+					Borrow(static_cast<Inner*>(a), static_cast<Inner*>(b), p, s, sib == a);
+				Pad(a);
+				Pad(b);
+				Pad(p);
+				return;
+			}
+			if(leaf)
+				Merge(static_cast<Leaf*>(a), static_cast<Leaf*>(b), p, s);
+			else
+				Merge(static_cast<Inner*>(a), static_cast<Inner*>(b), p, s);
+			for(unsigned int j = s + 1; j < p->c; ++j)
+			{
+				p->keys[j - 1] = p->keys[j];
+				p->kids[j] = p->kids[j + 1];
+			}
+			--p->c;
+			Pad(a);
+			x = p;
+		}
+		if(x == root && height > 0 && x->c == 0)
+		{	//The only child becomes the root
+			root = static_cast<Inner*>(x)->kids[0];
+			ialloc.Delete(static_cast<Inner*>(x));
+			--height;
+			return;
+		}
+		Pad(x);
+	}
+
+	/**
+	 * Moves one pair between neighbouring leaves a and b,
+	 * the children s and s + 1 of p
+	 * @param fromA True to move the last pair of a to b,
+	 * false to move the first pair of b to a
+	 */
+	static void Borrow(Leaf* a, Leaf* b, Inner* p, unsigned int s, bool fromA)
+	{
+		if(fromA)
+		{
+			for(unsigned int i = b->c; i > 0; --i)
+			{
+				b->keys[i] = b->keys[i - 1];
+				b->vals[i] = b->vals[i - 1];
+			}
+			b->keys[0] = a->keys[a->c - 1];
+			b->vals[0] = a->vals[a->c - 1];
+			++b->c;
+			--a->c;
+		}
+		else
+		{
+			a->keys[a->c] = b->keys[0];
+			a->vals[a->c] = b->vals[0];
+			++a->c;
+			for(unsigned int i = 1; i < b->c; ++i)
+			{
+				b->keys[i - 1] = b->keys[i];
+				b->vals[i - 1] = b->vals[i];
+			}
+			--b->c;
+		}
+		p->keys[s] = a->keys[a->c - 1];
+	}
+
+	/**
+	 * Moves one child between neighbouring inner nodes a
+	 * and b, the children s and s + 1 of p. The separator
+	 * in p moves down and the key next to the moved child
+	 * moves up
+	 * @param fromA True to move the last child of a to b,
+	 * false to move the first child of b to a
+	 */
+	static void Borrow(Inner* a, Inner* b, Inner* p, unsigned int s, bool fromA)
+	{
+		if(fromA)
+		{
+			b->kids[b->c + 1] = b->kids[b->c];
+			for(unsigned int i = b->c; i > 0; --i)
+			{
+				b->keys[i] = b->keys[i - 1];
+				b->kids[i] = b->kids[i - 1];
+			}
+			b->keys[0] = p->keys[s];
+			b->kids[0] = a->kids[a->c];
+			++b->c;
+			p->keys[s] = a->keys[a->c - 1];
+			--a->c;
+		}
+		else
+		{
+			a->keys[a->c] = p->keys[s];
+			a->kids[a->c + 1] = b->kids[0];
+			++a->c;
+			p->keys[s] = b->keys[0];
+			for(unsigned int i = 1; i < b->c; ++i)
+			{
+				b->keys[i - 1] = b->keys[i];
+				b->kids[i - 1] = b->kids[i];
+			}
+			b->kids[b->c - 1] = b->kids[b->c];
+			--b->c;
+		}
+	}
+
+	//Moves the pairs of leaf b, child s + 1 of p, to a and frees b
+	void Merge(Leaf* a, Leaf* b, Inner*, unsigned int)
+	{
+		for(unsigned int i = 0; i < b->c; ++i)
+		{
+			a->keys[a->c + i] = b->keys[i];
+			a->vals[a->c + i] = b->vals[i];
+		}
+		a->c += b->c;
+		a->next = b->next;
+		lalloc.Delete(b);
+	}
+
+	/**
+	 * Moves the separator s of p and the keys and children
+	 * of b, child s + 1 of p, to a and frees b
+	 */
+	void Merge(Inner* a, Inner* b, Inner* p, unsigned int s)
+	{
+		a->keys[a->c] = p->keys[s];
+		for(unsigned int i = 0; i < b->c; ++i)
+			a->keys[a->c + 1 + i] = b->keys[i];
+		for(unsigned int i = 0; i <= b->c; ++i)
+			a->kids[a->c + 1 + i] = b->kids[i];
+		a->c += 1 + b->c;
+		ialloc.Delete(b);
+	}
+
+	//Makes the map an empty leaf
+	void Init()
+	{
+		root = head = lalloc.New();
+		height = 0;
+		n = 0;
+	}
+
+	/**
+	 * Frees every node. Nodes without destructors are not
+	 * visited as the allocators release them all at once
+	 */
+	void Free()
+	{
+		if(!std::is_trivially_destructible<Leaf>::value || !std::is_trivially_destructible<Inner>::value)
+			FreeNode(root, 0);
+		lalloc.Clear();
+		ialloc.Clear();
+	}
+
+	//Destroys the subtree of a node at level l
+	void FreeNode(Node* x, unsigned int l)
+	{
+		if(l == height)
+		{
+			lalloc.Delete(static_cast<Leaf*>(x));
+			return;
+		}
+		Inner* in = static_cast<Inner*>(x);
+		for(unsigned int i = 0; i <= in->c; ++i)
+			FreeNode(in->kids[i], l + 1);
+		ialloc.Delete(in);
+	}
+
+	/**
+	 * Copies a BPlusTreeMap
+	 */
+	void Copy(const BPlusTreeMap& bm)
+	{
+		if(this == &bm)
+			return;
+		Free();
+		height = bm.height;
+		n = bm.n;
+		Leaf* last = NULL;
+		root = Clone(bm.root, 0, last);
+	}
+
+	/**
+	 * Copies the subtree of a node at level l, linking
+	 * the copied leaves in order
+	 * @param last The last leaf copied so far
+	 */
+	Node* Clone(const Node* x, unsigned int l, Leaf*& last)
+	{
+		if(l == height)
+		{
+			Leaf* leaf = lalloc.New(*static_cast<const Leaf*>(x));
+			leaf->next = NULL;
+			if(last == NULL)
+				head = leaf;
+			else
+				last->next = leaf;
+			last = leaf;
+			return leaf;
+		}
+		Inner* in = ialloc.New(*static_cast<const Inner*>(x));
+		for(unsigned int i = 0; i <= in->c; ++i)
+			in->kids[i] = Clone(in->kids[i], l + 1, last);
+		return in;
+	}
+
+	//The root and the first leaf
+	Node* root;
+	Leaf* head;
+	//Number of inner levels and number of elements
+	unsigned int height, n;
+	//Allocate the leaves and the inner nodes
+	SlabAllocator<Leaf> lalloc;
+	SlabAllocator<Inner> ialloc;
+};
+#endif
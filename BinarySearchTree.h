@@ -1,10 +1,17 @@
 #ifndef BINARYSEARCHTREE_H
 #define BINARYSEARCHTREE_H
-template <typename T>
+#include <type_traits>
+#include "SlabAllocator.h"
+/**
+ * An unbalanced binary search tree of values of type T. Nodes
+ * come from an allocator of type Alloc; see SlabAllocator.h
+ */
+template <typename T, template <typename> class Alloc = SlabAllocator>
 class BinarySearchTree
 {
 public:
 	const static int ELE_DNE = -123;
+	const static int DUP_ELE = -124;
 	//Default constructor
 	BinarySearchTree() 
 	{ 
@@ -17,7 +24,7 @@ public:
 	{
 		root = NULL;
 		n = 0;
-		Traverse(bst.root, &BinarySearchTree<T>::AddNode);
+		Traverse(bst.root, &BinarySearchTree::AddNode);
 	}
 
 	//Virtual Destructor
@@ -27,8 +34,9 @@ public:
 	}
 
 	/**
-	 * Inserts a value to the BST
-	 * @param val Is the value to insert
+	 * Finds a value in the BST. Throws
+	 * ELE_DNE if it is not found
+	 * @param val Is the value to find
 	 */
 	T& Find(const T& val) const
 	{ 	//Use private member function find
@@ -39,14 +47,47 @@ public:
 	}	
 
 	/**
-	 * Inserts a value to the BST
+	 * Finds a value in the BST without throwing
+	 * @param val Is the value to find
+	 * @return A pointer to the stored value or NULL
+	 */
+	T* TryFind(const T& val) const
+	{
+		Node* ret = Find(&root, val);
+		return ret == NULL ? NULL : &ret->val;
+	}
+
+	/**
+	 * Inserts a value to the BST. Throws
+	 * DUP_ELE if an equal value is in the BST
 	 * @param val Is the value to insert
 	 */
 	void Insert(const T& val) 
+	{
+		bool found;
+		FindOrInsert(val, found);
+		if(found)
+			throw DUP_ELE;
+	}
+
+	/**
+	 * Finds a value in the BST, inserting it if
+	 * it is not found. The tree is descended once
+	 * @param val Is the value to find or insert
+	 * @param found Output variable; true if an equal
+	 * value was already in the BST
+	 * @return The value stored in the BST
+	 */
+	T& FindOrInsert(const T& val, bool& found)
 	{ 	//Find the node (remove const qualifier)
 		Node*& node = const_cast<Node*&>(Find(&root, val));
-		node = new Node(val);
-		++n;
+		found = node != NULL;
+		if(!found)
+		{
+			node = alloc.New(val);
+			++n;
+		}
+		return node->val;
 	}
 
 	/**
@@ -59,7 +100,7 @@ public:
 		if(this == &bst)
 			return *this;
 		Destroy();
-		Traverse(bst.root, &BinarySearchTree<T>::AddNode);
+		Traverse(bst.root, &BinarySearchTree::AddNode);
 		return *this;
 	}
 	
@@ -81,6 +122,12 @@ public:
 		return n;
 	}
 
+	//Returns the number of calls to the system allocator
+	size_t SystemAllocs() const
+	{
+		return alloc.SystemAllocs();
+	}
+
 private:
 	/**
 	 * This class represents a node in the search tree
@@ -97,11 +144,15 @@ private:
 	
 	/**
 	 * Destroys the tree freeing all dynamic memory.
-	 * After calling the (now empty) tree is ready to be used
+	 * After calling the (now empty) tree is ready to be used.
+	 * Nodes without destructors are not visited if the
+	 * allocator can release them all at once
 	 */
 	void Destroy()
 	{
-		Traverse(root, &BinarySearchTree<T>::DestroyNode); 
+		if(!Alloc<Node>::BULK || !std::is_trivially_destructible<Node>::value)
+			Traverse(root, &BinarySearchTree::DestroyNode);
+		alloc.Clear();
 		root = NULL;
 		n = 0;
 	}
@@ -111,7 +162,7 @@ private:
 	 */
 	void DestroyNode(Node* ptr)
 	{
-		delete ptr;
+		alloc.Delete(ptr);
 	}
 
 	/**
@@ -150,19 +201,19 @@ private:
 		{
 			tempPtr = node;
 			node = node->right;
-			delete tempPtr;
+			alloc.Delete(tempPtr);
 		}
 		//Node only has left subtree
 		else if(node->left)
 		{
 			tempPtr = node;
 			node = node->left;
-			delete tempPtr;
+			alloc.Delete(tempPtr);
 		}
 		//Node is external
 		else
 		{
-			delete node;
+			alloc.Delete(node);
 			node = NULL;
 		}
 	}
@@ -212,5 +263,7 @@ private:
 	//Data members
 	Node* root;
 	unsigned int n;
+	//Allocates the nodes
+	Alloc<Node> alloc;
 };
 #endif
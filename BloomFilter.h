@@ -0,0 +1,257 @@
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+#include "Hash.h"
+
+/**
+ * A blocked Bloom filter. The bit array is split into 64 byte
+ * blocks, one cache line each. A key selects one block with the
+ * top bits of its hash and sets K bits inside it, so adding or
+ * testing a key touches one cache line. A filter never gives a
+ * false negative; a false positive happens with a probability
+ * that depends on the number of bits per key. A filter that
+ * outgrows its size adds a larger level rather than rehashing,
+ * since the keys are not stored. Hash is the hash functor type;
+ * see Hash.h.
+ */
+template <typename T, typename Hash = DefaultHash<T> >
+class BloomFilter
+{
+public:
+	/**
+	 * Creates an empty filter
+	 * @param capc The expected number of keys
+	 * @param bpk The number of bits per key
+	 */
+	BloomFilter(unsigned int capc = DEF_CAPC, unsigned int bpk = DEF_BITS)
+	{
+		top = NULL;
+		Init(capc, bpk);
+	}
+
+	//Copy constructor
+	BloomFilter(const BloomFilter& bf)
+	{
+		top = NULL;
+		Copy(bf);
+	}
+
+	//Destructor
+	~BloomFilter() { Free(); }
+
+	//Overloaded assignment operator
+	BloomFilter& operator=(const BloomFilter& bf)
+	{
+		Copy(bf);
+		return *this;
+	}
+
+	/**
+	 * Adds a key to the filter. When the filter holds
+	 * more keys than it was sized for a new level four
+	 * times as large is started, with GROW_BITS more bits
+	 * per key so the false positive rates of the levels
+	 * add up to a bounded total. Old levels are kept, so
+	 * no key is lost but lookups of missing keys check
+	 * every level
+	 * @param k The key
+	 */
+	void Add(const T& k)
+	{
+		if(top->n >= top->capc)
+			top = new Level(top->capc * 4, top->bpk + GROW_BITS, top);
+		top->Add(hf(k));
+		++n;
+	}
+
+	/**
+	 * Tests a key
+	 * @param k The key
+	 * @return False if k was never added; true if
+	 * it probably was
+	 */
+	bool MayContain(const T& k) const
+	{
+		uint64 h = hf(k);
+		for(const Level* l = top; l != NULL; l = l->prev)
+		{
+			if(l->Test(h))
+				return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Removes all keys and resizes the filter
+	 * to a single level
+	 * @param capc The expected number of keys
+	 */
+	void Clear(unsigned int capc)
+	{
+		Init(capc, bpk);
+	}
+
+	//Returns the number of keys added
+	unsigned int Size() const { return n; }
+
+	//Returns the number of levels
+	unsigned int Levels() const
+	{
+		unsigned int c = 0;
+		for(const Level* l = top; l != NULL; l = l->prev)
+			++c;
+		return c;
+	}
+
+	//Returns the number of bytes of the bit arrays
+	size_t Bytes() const
+	{
+		size_t b = 0;
+		for(const Level* l = top; l != NULL; l = l->prev)
+			b += (size_t) l->numBlocks * WORDS * sizeof(uint64);
+		return b;
+	}
+
+private:
+	//Default expected number of keys and bits per key
+	const static unsigned int DEF_CAPC = 1024;
+	const static unsigned int DEF_BITS = 10;
+	//Number of 64-bit words in a block
+	const static unsigned int WORDS = 8;
+	//Number of bits set per key
+	const static unsigned int K = 7;
+	//Extra bits per key of each new level
+	const static unsigned int GROW_BITS = 2;
+
+	/**
+	 * A fixed size blocked bit array with a power of
+	 * 2 number of blocks. Levels form a list from the
+	 * newest to the oldest
+	 */
+	class Level
+	{
+	public:
+		/**
+		 * Allocates an empty bit array aligned to 64
+		 * bytes so that every block is one cache line
+		 * @param c The expected number of keys
+		 * @param b The number of bits per key
+		 * @param p The previous level
+		 */
+		Level(unsigned int c, unsigned int b, Level* p)
+		{
+			unsigned long long bits = (unsigned long long) c * b;
+			numBlocks = 1;
+			shift = 64;
+			while((unsigned long long) numBlocks * WORDS * 64 < bits)
+			{
+				numBlocks *= 2;
+				--shift;
+			}
+			mem = new uint64[numBlocks * WORDS + WORDS];
+			size_t a = (size_t) mem % (WORDS * sizeof(uint64));
+			blocks = mem + (a == 0 ? 0 : (WORDS * sizeof(uint64) - a) / sizeof(uint64));
+			for(unsigned int i = 0; i < numBlocks * WORDS; ++i)
+				blocks[i] = 0;
+			bpk = b;
+			capc = (unsigned int) ((unsigned long long) numBlocks * WORDS * 64 / b);
+			n = 0;
+			prev = p;
+		}
+
+		~Level() { delete [] mem; }
+
+		//Sets the K bits of hash h
+		void Add(uint64 h)
+		{
+			uint64* b = blocks + Block(h) * WORDS;
+			uint64 g = MixBits(h);
+			unsigned int p = (unsigned int) g, s = (unsigned int) (g >> 32) | 1;
+			for(unsigned int i = 0; i < K; ++i, p += s)
+				b[(p >> 6) & (WORDS - 1)] |= 1ULL << (p & 63);
+			++n;
+		}
+
+		//True if all K bits of hash h are set
+		bool Test(uint64 h) const
+		{
+			const uint64* b = blocks + Block(h) * WORDS;
+			uint64 g = MixBits(h);
+			unsigned int p = (unsigned int) g, s = (unsigned int) (g >> 32) | 1;
+			for(unsigned int i = 0; i < K; ++i, p += s)
+			{
+				if(!((b[(p >> 6) & (WORDS - 1)] >> (p & 63)) & 1))
+					return false;
+			}
+			return true;
+		}
+
+		//The block of hash h; the top bits of h
+		unsigned int Block(uint64 h) const
+		{
+			return shift == 64 ? 0 : (unsigned int) (h >> shift);
+		}
+
+		//The allocation and the aligned blocks inside it
+		uint64* mem;
+		uint64* blocks;
+		//Number of blocks and shift selecting the block bits
+		unsigned int numBlocks, shift;
+		//Bits per key, number of keys sized for and added
+		unsigned int bpk, capc, n;
+		//The next older level
+		Level* prev;
+	};
+
+	/**
+	 * Frees all levels and starts an empty one
+	 * @param c The expected number of keys
+	 * @param b The number of bits per key
+	 */
+	void Init(unsigned int c, unsigned int b)
+	{
+		Free();
+		bpk = b;
+		n = 0;
+		top = new Level(c, bpk, NULL);
+	}
+
+	//Frees all levels
+	void Free()
+	{
+		while(top != NULL)
+		{
+			Level* l = top;
+			top = l->prev;
+			delete l;
+		}
+	}
+
+	//Copies a BloomFilter
+	void Copy(const BloomFilter& bf)
+	{
+		if(this == &bf)
+			return;
+		Free();
+		hf = bf.hf;
+		bpk = bf.bpk;
+		n = bf.n;
+		//Copy the levels newest first to keep their order
+		Level** p = &top;
+		for(const Level* l = bf.top; l != NULL; l = l->prev)
+		{
+			*p = new Level(l->capc, l->bpk, NULL);
+			for(unsigned int i = 0; i < l->numBlocks * WORDS; ++i)
+				(*p)->blocks[i] = l->blocks[i];
+			(*p)->n = l->n;
+			p = &(*p)->prev;
+		}
+	}
+
+	//The newest level; keys are added to it
+	Level* top;
+	//Bits per key and number of keys added
+	unsigned int bpk, n;
+	//The hash function
+	Hash hf;
+};
+#endif
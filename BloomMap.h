@@ -0,0 +1,208 @@
+#ifndef BLOOMMAP_H
+#define BLOOMMAP_H
+#include "Map.h"
+#include "BloomFilter.h"
+
+/**
+ * A Bloom filter in front of another map. A lookup of a key
+ * the filter has never seen returns without touching the map,
+ * which helps when most lookups miss and the map is slow to
+ * search (a tree or a binary search). The map is not owned and
+ * must only be changed through the BloomMap, or the filter will
+ * miss keys. Erase cannot remove a key from the filter; erased
+ * keys stay in it as stale bits until the filter is rebuilt
+ * by Load or Rebuild. Hash is the filter's hash functor type.
+ */
+template <typename T1, typename T2, typename Hash = DefaultHash<T1> >
+class BloomMap : public Map<T1, T2>
+{
+public:
+	//Thrown if the wrapped map is not empty
+	const static int NOT_EMPTY = -9753;
+
+	/**
+	* Attempts to erase the (key, value) pair
+	* with key  = k. The int ELE_DNE is thrown
+	* if the key is not in the map
+	* @param k Is the key of the pair to erase
+	*/
+	virtual void Erase(const T1& k)
+	{
+		map.Erase(k);
+		++stale;
+	}
+
+	/**
+	* Finds the corresponding value for a given key
+	* without throwing. The map is only searched if
+	* the filter may contain k
+	* @param k Is the key to search for
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
+	*/
+	virtual T2* TryFind(const T1& k) const
+	{
+		++queries;
+		if(!bf.MayContain(k))
+			return NULL;
+		++passed;
+		T2* p = map.TryFind(k);
+		if(p == NULL)
+			++falsePos;
+		return p;
+	}
+
+	/**
+	* Wraps an empty map
+	* @param m The map; the int NOT_EMPTY is
+	* thrown if it holds any elements
+	* @param capc The expected number of elements
+	* @param bpk The number of filter bits per key
+	*/
+	BloomMap(Map<T1, T2>& m, unsigned int capc = DEF_CAPC, unsigned int bpk = DEF_BITS) :
+		map(m), bf(capc, bpk)
+	{
+		if(m.Size() != 0)
+			throw NOT_EMPTY;
+		stale = 0;
+		ResetStats();
+	}
+
+	//Destructor; the wrapped map is left alone
+	virtual ~BloomMap() { }
+
+	/**
+	* Adds a (key, value) pair to the map. The int
+	* DUP_ELE is thrown if the key is already in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Put(const T1& k, const T2& v)
+	{
+		map.Put(k, v);
+		bf.Add(k);
+	}
+
+	/**
+	* Finds the corresponding value for a given key.
+	* If the key is not in the map the pair (k, T2())
+	* is added first
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	virtual T2& FindOrInsert(const T1& k)
+	{	//A key that is already in the filter needs no bits
+		if(bf.MayContain(k))
+		{
+			T2* p = map.TryFind(k);
+			if(p != NULL)
+				return *p;
+		}
+		T2& v = map.FindOrInsert(k);
+		bf.Add(k);
+		return v;
+	}
+
+	/**
+	* Sets the value for a given key, adding the
+	* (key, value) pair if the key is not in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Upsert(const T1& k, const T2& v)
+	{
+		FindOrInsert(k) = v;
+	}
+
+	/**
+	 * Bulk loads pairs and rebuilds the filter. If the map
+	 * is empty the filter is sized for exactly num keys and
+	 * all stale bits are dropped; otherwise the filter grows
+	 * as needed. The int DUP_ELE is thrown on a duplicate key;
+	 * the pairs before it stay in the map
+	 * @param keys The keys
+	 * @param vals The values
+	 * @param num The number of pairs
+	 */
+	void Load(const T1* keys, const T2* vals, unsigned int num)
+	{
+		if(map.Size() == 0)
+		{
+			bf.Clear(num > 0 ? num : DEF_CAPC);
+			stale = 0;
+		}
+		for(unsigned int i = 0; i < num; ++i)
+			Put(keys[i], vals[i]);
+	}
+
+	/**
+	 * Rebuilds the filter from the full set of keys in
+	 * the map, dropping the bits of erased keys. Every key
+	 * in the map must be passed or lookups will miss it
+	 * @param keys The keys in the map
+	 * @param num The number of keys
+	 */
+	void Rebuild(const T1* keys, unsigned int num)
+	{
+		bf.Clear(num > 0 ? num : DEF_CAPC);
+		for(unsigned int i = 0; i < num; ++i)
+			bf.Add(keys[i]);
+		stale = 0;
+	}
+
+	/**
+	 * Returns the number of elements in the Map
+	 * @return: Number of elements in map object
+	 */
+	virtual unsigned int Size() const
+	{
+		return map.Size();
+	}
+
+	//Returns the number of erased keys still in the filter
+	unsigned int Stale() const { return stale; }
+
+	//Returns the number of TryFind calls
+	unsigned long long Queries() const { return queries; }
+
+	//Returns the number of TryFind calls the filter did not stop
+	unsigned long long Passed() const { return passed; }
+
+	/**
+	 * Returns the fraction of lookups of missing keys
+	 * that the filter let through to the map
+	 */
+	double FalsePositiveRate() const
+	{
+		unsigned long long neg = queries - passed + falsePos;
+		return neg == 0 ? 0.0 : (double) falsePos / neg;
+	}
+
+	//Resets the lookup counters
+	void ResetStats()
+	{
+		queries = passed = falsePos = 0;
+	}
+
+	//Returns the number of bytes used by the filter
+	size_t FilterBytes() const { return bf.Bytes(); }
+
+private:
+	//Default expected number of elements and bits per key
+	const static unsigned int DEF_CAPC = 1024;
+	const static unsigned int DEF_BITS = 10;
+
+	//The map is shared, not copied
+	BloomMap(const BloomMap&);
+	BloomMap& operator=(const BloomMap&);
+
+	//The wrapped map
+	Map<T1, T2>& map;
+	//The filter of all keys added since the last rebuild
+	BloomFilter<T1, Hash> bf;
+	//Number of erased keys still in the filter
+	unsigned int stale;
+	//Lookup counters
+	mutable unsigned long long queries, passed, falsePos;
+};
+#endif
@@ -0,0 +1,200 @@
+#ifndef CONCURRENTHASHMAP_H
+#define CONCURRENTHASHMAP_H
+#include <mutex>
+#include "HashMap.h"
+
+/**
+ * A thread safe map implementation. Keys are spread over a
+ * power of 2 number of segments by a hash function independent
+ * of the one used inside each segment. Each segment is a HashMap
+ * guarded by its own mutex so operations on different segments
+ * run in parallel. Hash and Capc are passed on to the segments.
+ * Note: Find and TryFind point into a segment. The value stays
+ * valid only until the key is erased or its segment grows; use
+ * Get to copy the value out while holding the lock.
+ */
+template <typename T1, typename T2, typename Hash = DefaultHash<T1>, typename Capc = Pow2Capacity>
+class ConcurrentHashMap : public Map<T1, T2>
+{
+public:
+	/**
+	* Attempts to erase the (key, value) pair
+	* with key  = k. The int ELE_DNE is thrown
+	* if the key is not in the map
+	* @param k Is the key of the pair to erase
+	*/
+	virtual void Erase(const T1& k)
+	{
+		Segment& s = Seg(k);
+		std::lock_guard<std::mutex> lg(s.lock);
+		s.map.Erase(k);
+	}
+
+	/**
+	* Finds the corresponding value for a given
+	* key without throwing
+	* @param k Is the key to search for
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
+	*/
+	virtual T2* TryFind(const T1& k) const
+	{
+		Segment& s = Seg(k);
+		std::lock_guard<std::mutex> lg(s.lock);
+		return s.map.TryFind(k);
+	}
+
+	/**
+	* Copies the value for a given key while the
+	* segment is locked
+	* @param k Is the key to search for
+	* @param v Output variable of the value
+	* @return True if the key is found false otherwise
+	*/
+	bool Get(const T1& k, T2& v) const
+	{
+		Segment& s = Seg(k);
+		std::lock_guard<std::mutex> lg(s.lock);
+		const T2* p = s.map.TryFind(k);
+		if(p == NULL)
+			return false;
+		v = *p;
+		return true;
+	}
+
+	/**
+	* Create a map with a default number of segments
+	*/
+	ConcurrentHashMap()
+	{
+		Init(DEF_SEGS);
+	}
+
+	/**
+	* Create a map with a given number of segments
+	* @param ns The number of segments; rounded up
+	* to a power of 2. Use 1 for a single global lock
+	*/
+	ConcurrentHashMap(unsigned int ns)
+	{
+		Init(ns);
+	}
+
+	//Destructor
+	virtual ~ConcurrentHashMap() { delete [] segs; }
+
+	/**
+	* Adds a (key, value) pair to the map. The int
+	* DUP_ELE is thrown if the key is already in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Put(const T1& k, const T2& v)
+	{
+		Segment& s = Seg(k);
+		std::lock_guard<std::mutex> lg(s.lock);
+		s.map.Put(k, v);
+	}
+
+	/**
+	* Finds the corresponding value for a given key,
+	* adding the pair (k, T2()) first if the key is not
+	* in the map. The lock is released on return, so
+	* writes through the reference are not synchronized
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	virtual T2& FindOrInsert(const T1& k)
+	{
+		Segment& s = Seg(k);
+		std::lock_guard<std::mutex> lg(s.lock);
+		return s.map.FindOrInsert(k);
+	}
+
+	/**
+	* Sets the value for a given key while the segment
+	* is locked, adding the pair if the key is not in
+	* the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Upsert(const T1& k, const T2& v)
+	{
+		Segment& s = Seg(k);
+		std::lock_guard<std::mutex> lg(s.lock);
+		s.map.Upsert(k, v);
+	}
+
+	/**
+	 * Returns the number of elements in the Map. Each
+	 * segment is counted under its lock; concurrent updates
+	 * to other segments may or may not be included
+	 * @return: Number of elements in map object
+	 */
+	virtual unsigned int Size() const
+	{
+		unsigned int n = 0;
+		for(unsigned int i = 0; i < numSegs; ++i)
+		{
+			std::lock_guard<std::mutex> lg(segs[i].lock);
+			n += segs[i].map.Size();
+		}
+		return n;
+	}
+
+private:
+	//Default number of segments
+	const static unsigned int DEF_SEGS = 64;
+
+	/**
+	 * A segment of the map. The padding keeps the
+	 * hot fields of neighbouring segments on
+	 * different cache lines.
+	 */
+	class Segment
+	{
+	public:
+		std::mutex lock;
+		HashMap<T1, T2, Hash, Capc> map;
+		char pad[64];
+	};
+
+	//Mutexes are not copyable
+	ConcurrentHashMap(const ConcurrentHashMap&);
+	ConcurrentHashMap& operator=(const ConcurrentHashMap&);
+
+	/**
+	 * Allocates the segments
+	 * @param ns The minimum number of segments
+	 */
+	void Init(unsigned int ns)
+	{
+		numSegs = 1;
+		shift = 64;
+		while(numSegs < ns)
+		{
+			numSegs *= 2;
+			--shift;
+		}
+		segs = new Segment[numSegs];
+	}
+
+	/**
+	 * Gets the segment holding key k. The top
+	 * bits of the hash select the segment
+	 * @param k The key
+	 * @return The segment
+	 */
+	Segment& Seg(const T1& k) const
+	{
+		return numSegs == 1 ? segs[0] : segs[hf(k) >> shift];
+	}
+
+	//The segments
+	Segment* segs;
+	//Number of segments and shift selecting the segment bits
+	unsigned int numSegs, shift;
+	//The hash function used to pick a segment
+	Hash hf;
+};
+#endif
@@ -0,0 +1,380 @@
+#ifndef CUCKOOMAP_H
+#define CUCKOOMAP_H
+#include <cstdlib>
+#include "Hash.h"
+typedef unsigned int Index;
+
+/**
+ * A map implementation that uses bucketized cuckoo hashing.
+ * Every key has exactly two candidate buckets of WAYS slots,
+ * so Find and Erase compare at most 2 * WAYS keys no matter
+ * how full the table is. Put evicts a random element to its
+ * other bucket when both buckets are full and grows the table
+ * if no place is found after MAX_KICKS evictions. The bucket
+ * functions come from the universal family (a * h + b) >> s
+ * with random odd a, applied to the output of the Hash functor.
+ * Hash is the hash functor type; see Hash.h.
+ */
+template <typename T1, typename T2, typename Hash = DefaultHash<T1> >
+class CuckooMap : public Map<T1, T2>
+{
+public:
+	/**
+	* Attempts to erase the (key, value) pair
+	* with key  = k. The int ELE_DNE is thrown
+	* if the key is not in the map
+	* @param k Is the key of the pair to erase
+	*/
+	virtual void Erase(const T1& k)
+	{
+		Index b, w;
+		if(!Locate(k, b, w))
+			throw this->ELE_DNE;
+		buckets[b].used &= ~(1u << w);
+		--n;
+	}
+
+	/**
+	* Finds the corresponding value for a given
+	* key without throwing
+	* @param k Is the key to search for
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
+	*/
+	virtual T2* TryFind(const T1& k) const
+	{
+		Index b, w;
+		if(!Locate(k, b, w))
+			return NULL;
+		return &buckets[b].vals[w];
+	}
+
+	/**
+	* Create a map with a default initial
+	* capacity
+	*/
+	CuckooMap()
+	{
+		Init(DEF_CAPC);
+	}
+
+	/**
+	* Create a map with a initial capacity
+	* @param capc The initial capacity
+	*/
+	CuckooMap(unsigned int capc)
+	{
+		Init(capc);
+	}
+
+	//Copy constructor
+	CuckooMap(const CuckooMap& cm)
+	{
+		buckets = NULL;
+		Copy(cm);
+	}
+
+	//Destructor
+	virtual ~CuckooMap() { delete [] buckets; }
+
+	//Overloaded assignment operator
+	CuckooMap& operator=(const CuckooMap& cm)
+	{
+		Copy(cm);
+		return *this;
+	}
+
+	/**
+	* Adds a (key, value) pair to the map. The int
+	* DUP_ELE is thrown if the key is already in the
+	* map; a key may only occupy one of its two buckets
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Put(const T1& k, const T2& v)
+	{
+		bool found;
+		Insert(k, v, found);
+		if(found)
+			throw this->DUP_ELE;
+	}
+
+	/**
+	* Finds the corresponding value for a given key.
+	* If the key is not in the map the pair (k, T2())
+	* is added first
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	virtual T2& FindOrInsert(const T1& k)
+	{
+		bool found;
+		return *Insert(k, T2(), found);
+	}
+
+	/**
+	* Sets the value for a given key, adding the
+	* (key, value) pair if the key is not in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Upsert(const T1& k, const T2& v)
+	{
+		bool found;
+		T2* p = Insert(k, v, found);
+		if(found)
+			*p = v;
+	}
+
+	/**
+	 * Returns the number of elements in the Map
+	 * @return: Number of elements in map object
+	 */
+	virtual unsigned int Size() const
+	{
+		return n;
+	}
+
+private:
+	//Number of slots in a bucket
+	const static Index WAYS = 4;
+	//Default capacity of the table
+	const static int DEF_CAPC = 16;
+	//Maximum load factor in percent
+	const static unsigned int MAX_LOAD = 90;
+	//Evictions tried before the table is grown
+	const static unsigned int MAX_KICKS = 500;
+
+	/**
+	 * A bucket of WAYS slots. Bit i of used is set
+	 * when slot i holds a pair
+	 */
+	class Bucket
+	{
+	public:
+		Bucket() { used = 0; }
+		T1 keys[WAYS];
+		T2 vals[WAYS];
+		unsigned char used;
+	};
+
+	/**
+	 * Allocates an empty table and picks new
+	 * bucket functions
+	 * @param capc The minimum number of slots
+	 */
+	void Init(unsigned int capc)
+	{	//Number of buckets must be a power of 2
+		numBuckets = 2;
+		shift = 63;
+		while(numBuckets * WAYS < capc)
+		{
+			numBuckets *= 2;
+			--shift;
+		}
+		n = 0;
+		buckets = new Bucket[numBuckets];
+		hf = Hash();
+		for(unsigned int i = 0; i < 2; ++i)
+		{
+			a[i] = RandomSeed() | 1;
+			b[i] = RandomSeed();
+		}
+	}
+
+	/**
+	 * Copies a CuckooMap
+	 */
+	void Copy(const CuckooMap& cm)
+	{
+		if(this == &cm)
+			return;
+		delete [] buckets;
+		hf = cm.hf;
+		numBuckets = cm.numBuckets;
+		shift = cm.shift;
+		n = cm.n;
+		for(unsigned int i = 0; i < 2; ++i)
+		{
+			a[i] = cm.a[i];
+			b[i] = cm.b[i];
+		}
+		buckets = new Bucket[numBuckets];
+		for(Index i = 0; i < numBuckets; ++i)
+			buckets[i] = cm.buckets[i];
+	}
+
+	/**
+	 * Finds the bucket and slot holding key k. Only
+	 * the two candidate buckets of k are searched
+	 * @param k The key to search for
+	 * @param bi Output variable of the bucket of k
+	 * @param w Output variable of the slot of k
+	 * @return True if the key is found false otherwise
+	 */
+	bool Locate(const T1& k, Index& bi, Index& w) const
+	{
+		uint64 h = hf(k);
+		Index c[2] = { F(h, 0), F(h, 1) };
+#ifdef __GNUC__
+		//Load the second bucket while the first is searched
+		__builtin_prefetch(buckets + c[1]);
+#endif
+		for(unsigned int i = 0; i < 2; ++i)
+		{
+			const Bucket& bk = buckets[c[i]];
+			for(w = 0; w < WAYS; ++w)
+			{
+				if(((bk.used >> w) & 1) && bk.keys[w] == k)
+				{
+					bi = c[i];
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Finds the value of key k, adding (k, v) if k is
+	 * not in the map
+	 * @param k Is the key
+	 * @param v Is the value to add
+	 * @param found Output variable; true if k was
+	 * already in the map
+	 * @return The value corresponding to k
+	 */
+	T2* Insert(const T1& k, const T2& v, bool& found)
+	{
+		Index bi, w;
+		found = Locate(k, bi, w);
+		if(found)
+			return &buckets[bi].vals[w];
+		//Evictions get long as the table fills up
+		if((n + 1) * 100ULL > (unsigned long long) numBuckets * WAYS * MAX_LOAD)
+			Rehash(numBuckets * 2);
+		T2* p = Place(k, v);
+		++n;
+		if(p != NULL)
+			return p;
+		//Evictions may have moved k again
+		Locate(k, bi, w);
+		return &buckets[bi].vals[w];
+	}
+
+	/**
+	 * Puts a pair in a free slot of bucket bi
+	 * @return The value in the bucket or NULL
+	 * if the bucket is full
+	 */
+	T2* Add(Index bi, const T1& k, const T2& v)
+	{
+		Bucket& bk = buckets[bi];
+		for(Index w = 0; w < WAYS; ++w)
+		{
+			if(!((bk.used >> w) & 1))
+			{
+				bk.keys[w] = k;
+				bk.vals[w] = v;
+				bk.used |= 1u << w;
+				return &bk.vals[w];
+			}
+		}
+		return NULL;
+	}
+
+	/**
+	 * Puts a pair that is not in the map into one of
+	 * its buckets. If both are full a random element of
+	 * the bucket is evicted and moved to its other bucket,
+	 * and so on. The table grows if the evictions do not
+	 * end within MAX_KICKS. Does not change n
+	 * @param k Is the key
+	 * @param v Is the value
+	 * @return The value of k or NULL if evictions
+	 * were needed and k may have moved
+	 */
+	T2* Place(T1 k, T2 v)
+	{
+		uint64 h = hf(k);
+		Index bi = F(h, 0);
+		T2* p = Add(bi, k, v);
+		if(p != NULL)
+			return p;
+		bi = F(h, 1);
+		p = Add(bi, k, v);
+		if(p != NULL)
+			return p;
+		for(unsigned int i = 0; i < MAX_KICKS; ++i)
+		{	//Swap the pair with a random one of bucket bi
+			Index w = (Index) rand() % WAYS;
+			Swap(k, buckets[bi].keys[w]);
+			Swap(v, buckets[bi].vals[w]);
+			//Move the evicted pair to its other bucket
+			h = hf(k);
+			Index b0 = F(h, 0);
+			bi = b0 == bi ? F(h, 1) : b0;
+			if(Add(bi, k, v) != NULL)
+				return NULL;
+		}
+		//Evicted pair is the only one without a slot
+		Rehash(numBuckets * 2);
+		Place(k, v);
+		return NULL;
+	}
+
+	/**
+	* Resize the map's array
+	* @param nb The new number of buckets
+	*/
+	void Rehash(unsigned int nb)
+	{
+		Bucket* ob = buckets;
+		Index oldNum = numBuckets;
+		unsigned int oldN = n;
+		//Init also picks new bucket functions
+		Init(nb * WAYS);
+		for(Index i = 0; i < oldNum; ++i)
+		{
+			for(Index w = 0; w < WAYS; ++w)
+			{
+				if((ob[i].used >> w) & 1)
+					Place(ob[i].keys[w], ob[i].vals[w]);
+			}
+		}
+		n = oldN;
+		delete [] ob;
+	}
+
+	/**
+	* The bucket functions
+	* @param h The hash of the key
+	* @param i Which of the two functions to use
+	* @return The resulting bucket index
+	*/
+	Index F(uint64 h, unsigned int i) const
+	{
+		return (Index) ((a[i] * h + b[i]) >> shift);
+	}
+
+	//Swaps x and y
+	template <typename T>
+	static void Swap(T& x, T& y)
+	{
+		T t = x;
+		x = y;
+		y = t;
+	}
+
+	//The buckets
+	Bucket* buckets;
+	//Number of elements and buckets
+	unsigned int n, numBuckets;
+	//Shift selecting the top bits for the bucket index
+	unsigned int shift;
+	//Multipliers and offsets of the two bucket functions
+	uint64 a[2], b[2];
+	//The hash function
+	Hash hf;
+};
+#endif
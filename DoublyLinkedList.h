@@ -1,7 +1,13 @@
 #ifndef LINKEDLIST_H
 #define LINKEDLIST_H
+#include <type_traits>
 #include "List.h"
-template <typename T>
+#include "SlabAllocator.h"
+/**
+ * A doubly linked list. Nodes come from an allocator
+ * of type Alloc; see SlabAllocator.h
+ */
+template <typename T, template <typename> class Alloc = SlabAllocator>
 class LinkedList : public List<T>
 {
 public:
@@ -11,7 +17,7 @@ public:
 	 */
 	virtual void Add(const T& ele)
 	{	//Create the new list node
-		Node* newNode = new Node(ele, NULL, tail);
+		Node* newNode = alloc.New(ele, (Node*) NULL, tail);
 		if(tail == NULL)
 		{	//List is empty
 			head = tail = newNode;
@@ -27,12 +33,23 @@ public:
 	}
 
 	/**
-	 * Clears the list
+	 * Clears the list. Nodes without destructors are not
+	 * visited if the allocator can release them all at once
 	 */
 	virtual void Clear()
 	{
-		while(Size() > 0)
-			Remove(0);
+		if(!Alloc<Node>::BULK || !std::is_trivially_destructible<Node>::value)
+		{
+			while(head != NULL)
+			{
+				Node* oldNode = head;
+				head = head->next;
+				alloc.Delete(oldNode);
+			}
+		}
+		alloc.Clear();
+		head = tail = NULL;
+		n = 0;
 	}
 	
 	/**
@@ -118,7 +135,7 @@ public:
 	    Node* lstPtr = head;
 		if(n == 1)
 		{	//Only have one element
-			delete head;
+			alloc.Delete(head);
 			head = tail = NULL;
 			n = 0;
 			return;
@@ -131,19 +148,19 @@ public:
 		{	//At the front of the list
 			head = head->next;
 			head->prev = NULL;
-			delete lstPtr;
+			alloc.Delete(lstPtr);
 		}	
 		else if(lstPtr->next == NULL)
 		{	//At the end
 			tail = tail->prev;
 			tail->next = NULL;
-			delete lstPtr;
+			alloc.Delete(lstPtr);
 		}			
 		else
 		{	//In the middle
 			lstPtr->prev->next = lstPtr->next;
 			lstPtr->next->prev = lstPtr->prev;
-			delete lstPtr;
+			alloc.Delete(lstPtr);
 		}
 	    --n;
 	}
@@ -172,6 +189,12 @@ public:
 	{
 		return n;
 	}
+
+	//Returns the number of calls to the system allocator
+	size_t SystemAllocs() const
+	{
+		return alloc.SystemAllocs();
+	}
 	
 private:
 
@@ -202,5 +225,7 @@ private:
 	Node* tail;
 	Node* head;
 	unsigned int n;
+	//Allocates the nodes
+	Alloc<Node> alloc;
 };
 #endif
@@ -0,0 +1,453 @@
+#ifndef EPOCHHASHMAP_H
+#define EPOCHHASHMAP_H
+#include <atomic>
+#include <mutex>
+#include "Hash.h"
+
+/**
+ * A read optimized concurrent map implementation for
+ * workloads that are mostly lookups. Writers are serialized
+ * by a mutex; readers never lock and only write to their own
+ * cache line. Slot states are published with release stores,
+ * and a filled slot is never changed in place. Erase leaves
+ * a tombstone, and a grow or cleanup builds a new table. The
+ * new table is published atomically. The old one is freed by
+ * epoch based reclamation once no reader can still see it.
+ *
+ * Lock free lookups go through a Reader handle, one per
+ * thread. The Map interface functions take the writer lock.
+ * A reference returned by Find stays valid only until the
+ * next Put or Erase.
+ */
+template <typename T1, typename T2, typename Hash = DefaultHash<T1>, typename Capc = Pow2Capacity>
+class EpochHashMap : public Map<T1, T2>
+{
+	class Table;
+public:
+	//Thrown when all reader slots are taken
+	const static int NO_READER = -8642;
+
+	/**
+	 * A handle for lock free lookups. Each thread creates its
+	 * own Reader; a Reader must not be shared between threads
+	 * and must be destroyed before the map.
+	 */
+	class Reader
+	{
+	public:
+		/**
+		 * Claims a reader slot. The int NO_READER
+		 * is thrown if all slots are in use
+		 * @param em The map to read
+		 */
+		Reader(const EpochHashMap& em) : map(em)
+		{
+			for(slot = 0; slot < MAX_READERS; ++slot)
+			{
+				bool f = false;
+				if(map.rs[slot].used.compare_exchange_strong(f, true))
+					return;
+			}
+			throw NO_READER;
+		}
+
+		//Releases the reader slot
+		~Reader()
+		{
+			map.rs[slot].used.store(false, std::memory_order_release);
+		}
+
+		/**
+		 * Copies the value for a given key
+		 * @param k Is the key to search for
+		 * @param v Output variable of the value
+		 * @return True if the key is found false otherwise
+		 */
+		bool Get(const T1& k, T2& v) const
+		{	//Announce the epoch before loading the table
+			std::atomic<uint64>& e = map.rs[slot].epoch;
+			e.store(map.epoch.load(std::memory_order_acquire));
+			const Table* t = map.table.load();
+			Index j;
+			bool found = t->Locate(k, j);
+			if(found)
+				v = t->slots[j].val;
+			e.store(QUIESCENT, std::memory_order_release);
+			return found;
+		}
+
+	private:
+		//Not copyable; each Reader owns a slot
+		Reader(const Reader&);
+		Reader& operator=(const Reader&);
+
+		const EpochHashMap& map;
+		unsigned int slot;
+	};
+
+	/**
+	* Attempts to erase the (key, value) pair
+	* with key  = k. The int ELE_DNE is thrown
+	* if the key is not in the map
+	* @param k Is the key of the pair to erase
+	*/
+	virtual void Erase(const T1& k)
+	{
+		std::lock_guard<std::mutex> lg(wlock);
+		Table* t = table.load(std::memory_order_relaxed);
+		Index j;
+		if(!t->Locate(k, j))
+			throw this->ELE_DNE;
+		//Readers skip tombstones; the slot is not reused
+		t->state[j].store(DELETED, std::memory_order_release);
+		--n;
+	}
+
+	/**
+	* Finds the corresponding value for a given
+	* key without throwing
+	* @param k Is the key to search for
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
+	*/
+	virtual T2* TryFind(const T1& k) const
+	{
+		std::lock_guard<std::mutex> lg(wlock);
+		Table* t = table.load(std::memory_order_relaxed);
+		Index j;
+		if(!t->Locate(k, j))
+			return NULL;
+		return &t->slots[j].val;
+	}
+
+	/**
+	* Create a map with a default initial
+	* capacity
+	*/
+	EpochHashMap()
+	{
+		Init(DEF_CAPC);
+	}
+
+	/**
+	* Create a map with a initial capacity
+	* @param capc The initial capacity
+	*/
+	EpochHashMap(unsigned int capc)
+	{
+		Init(capc);
+	}
+
+	//Destructor; no Reader may still exist
+	virtual ~EpochHashMap()
+	{
+		delete table.load();
+		while(retired != NULL)
+		{
+			Table* t = retired;
+			retired = t->next;
+			delete t;
+		}
+	}
+
+	/**
+	* Adds a (key, value) pair to the map. The int
+	* DUP_ELE is thrown if the key is already in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Put(const T1& k, const T2& v)
+	{
+		std::lock_guard<std::mutex> lg(wlock);
+		Table* t = table.load(std::memory_order_relaxed);
+		Index j;
+		if(t->Locate(k, j))
+			throw this->DUP_ELE;
+		Add(t, j, k, v);
+	}
+
+	/**
+	* Finds the corresponding value for a given key,
+	* adding the pair (k, T2()) first if the key is not
+	* in the map. Writing through the reference races
+	* with Readers; use Upsert to change a value that
+	* Readers may see
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	virtual T2& FindOrInsert(const T1& k)
+	{
+		std::lock_guard<std::mutex> lg(wlock);
+		Table* t = table.load(std::memory_order_relaxed);
+		Index j;
+		if(t->Locate(k, j))
+			return t->slots[j].val;
+		return Add(t, j, k, T2());
+	}
+
+	/**
+	* Sets the value for a given key, adding the
+	* (key, value) pair if the key is not in the map.
+	* A filled slot is never changed; the pair is
+	* published in a new slot further along the probe
+	* sequence before the old slot becomes a tombstone,
+	* so Readers always see the old or the new value
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Upsert(const T1& k, const T2& v)
+	{
+		std::lock_guard<std::mutex> lg(wlock);
+		Table* t = table.load(std::memory_order_relaxed);
+		Index j;
+		if(!t->Locate(k, j))
+		{
+			Add(t, j, k, v);
+			return;
+		}
+		//Full and deleted slots count towards the load
+		if(t->used + 1 > t->max / 2)
+		{
+			t = Rebuild();
+			t->Locate(k, j);
+		}
+		t->Insert(k, v, j);
+		t->state[j].store(DELETED, std::memory_order_release);
+		if(retired != NULL)
+			Reclaim();
+	}
+
+	/**
+	 * Returns the number of elements in the Map
+	 * @return: Number of elements in map object
+	 */
+	virtual unsigned int Size() const
+	{
+		std::lock_guard<std::mutex> lg(wlock);
+		return n;
+	}
+
+private:
+	//Default capacity of a table
+	const static int DEF_CAPC = 16;
+	//Maximum number of concurrent Readers
+	const static unsigned int MAX_READERS = 128;
+	//Slot states
+	const static unsigned char EMPTY = 0;
+	const static unsigned char FULL = 1;
+	const static unsigned char DELETED = 2;
+	//Epoch announced by a reader outside of a lookup
+	const static uint64 QUIESCENT = ~0ULL;
+
+	/**
+	 * A (key, value) slot; occupancy is kept
+	 * in the table's state array
+	 */
+	class Slot
+	{
+	public:
+		T1 key;
+		T2 val;
+	};
+
+	/**
+	 * A linear probing hash table. Only the writer
+	 * modifies a table and only through Insert and
+	 * the state of a full slot.
+	 */
+	class Table
+	{
+	public:
+		Table(unsigned int capc)
+		{
+			max = Capc::Round(capc);
+			cp.Resize(max);
+			used = 0;
+			next = NULL;
+			state = new std::atomic<unsigned char>[max];
+			for(Index i = 0; i < max; ++i)
+				state[i].store(EMPTY, std::memory_order_relaxed);
+			slots = new Slot[max];
+		}
+
+		~Table()
+		{
+			delete [] state;
+			delete [] slots;
+		}
+
+		/**
+		 * Finds the full slot holding key k
+		 * @param k The key to search for
+		 * @param j Output variable of the slot of k
+		 * @return True if the key is found false otherwise
+		 */
+		bool Locate(const T1& k, Index& j) const
+		{
+			j = cp.Home(hf(k));
+			for(Index p = 0; p < max; ++p)
+			{
+				unsigned char s = state[j].load(std::memory_order_acquire);
+				if(s == EMPTY)
+					return false;
+				if(s == FULL && slots[j].key == k)
+					return true;
+				j = cp.Next(j);
+			}
+			return false;
+		}
+
+		/**
+		 * Writes a pair into the first empty slot
+		 * and then publishes it to readers
+		 */
+		void Insert(const T1& k, const T2& v)
+		{
+			Insert(k, v, cp.Home(hf(k)));
+		}
+
+		/**
+		 * Writes a pair into the first empty slot at
+		 * or after slot j and then publishes it to readers
+		 * @return The slot of the pair
+		 */
+		Index Insert(const T1& k, const T2& v, Index j)
+		{
+			while(state[j].load(std::memory_order_relaxed) != EMPTY)
+				j = cp.Next(j);
+			slots[j].key = k;
+			slots[j].val = v;
+			state[j].store(FULL, std::memory_order_release);
+			++used;
+			return j;
+		}
+
+		std::atomic<unsigned char>* state;
+		Slot* slots;
+		//Capacity and number of full or deleted slots
+		unsigned int max, used;
+		Capc cp;
+		Hash hf;
+		//Retired list link and the epoch it was retired in
+		Table* next;
+		uint64 epoch;
+	};
+
+	/**
+	 * Per reader state. The padding gives each
+	 * reader its own cache line
+	 */
+	class ReaderSlot
+	{
+	public:
+		ReaderSlot() : epoch(QUIESCENT), used(false) { }
+		std::atomic<uint64> epoch;
+		std::atomic<bool> used;
+		char pad[64];
+	};
+
+	//Not copyable while readers may be attached
+	EpochHashMap(const EpochHashMap&);
+	EpochHashMap& operator=(const EpochHashMap&);
+
+	/**
+	 * Creates the first table
+	 * @param capc The initial capacity
+	 */
+	void Init(unsigned int capc)
+	{
+		n = 0;
+		epoch.store(0);
+		retired = NULL;
+		table.store(new Table(capc));
+	}
+
+	/**
+	 * Adds a pair that is not in the map. Locate
+	 * left j at the empty slot that ended the search,
+	 * which is where the pair goes unless the table
+	 * has to be rebuilt first
+	 * @param t The current table
+	 * @param j The slot from Locate
+	 * @return The value in the table
+	 */
+	T2& Add(Table* t, Index j, const T1& k, const T2& v)
+	{	//Full and deleted slots count towards the load
+		if(t->used + 1 > t->max / 2)
+		{
+			t = Rebuild();
+			t->Locate(k, j);
+		}
+		j = t->Insert(k, v, j);
+		++n;
+		if(retired != NULL)
+			Reclaim();
+		return t->slots[j].val;
+	}
+
+	/**
+	 * Copies the live pairs into a new table, doubling
+	 * the capacity if more than a quarter of the slots are
+	 * live, and publishes it. The old table is retired
+	 * @return The new table
+	 */
+	Table* Rebuild()
+	{
+		Table* old = table.load(std::memory_order_relaxed);
+		Table* t = new Table(n * 4 >= old->max ? old->max * 2 : old->max);
+		for(Index i = 0; i < old->max; ++i)
+		{
+			if(old->state[i].load(std::memory_order_relaxed) == FULL)
+				t->Insert(old->slots[i].key, old->slots[i].val);
+		}
+		//Readers that load the table after this see t
+		table.store(t);
+		old->epoch = epoch.fetch_add(1);
+		old->next = retired;
+		retired = old;
+		return t;
+	}
+
+	/**
+	 * Frees the retired tables no reader can still
+	 * hold. A reader that announced an epoch later than
+	 * a table's retire epoch loaded the table pointer
+	 * after the table was replaced
+	 */
+	void Reclaim()
+	{
+		uint64 oldest = QUIESCENT;
+		for(unsigned int i = 0; i < MAX_READERS; ++i)
+		{
+			uint64 e = rs[i].epoch.load();
+			if(e < oldest)
+				oldest = e;
+		}
+		Table** p = &retired;
+		while(*p != NULL)
+		{
+			if((*p)->epoch < oldest)
+			{
+				Table* t = *p;
+				*p = t->next;
+				delete t;
+			}
+			else
+				p = &(*p)->next;
+		}
+	}
+
+	//The current table
+	std::atomic<Table*> table;
+	//The global epoch
+	std::atomic<uint64> epoch;
+	//Tables waiting to be freed; writer only
+	Table* retired;
+	//Number of elements; writer only
+	unsigned int n;
+	//Serializes writers
+	mutable std::mutex wlock;
+	//Reader slots
+	mutable ReaderSlot rs[MAX_READERS];
+};
+#endif
@@ -0,0 +1,294 @@
+#ifndef HASH_H
+#define HASH_H
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <type_traits>
+/**
+ * Hash functors and capacity policies for the hash table
+ * maps. A functor is default constructible, copyable and maps
+ * a key to a 64-bit hash with operator(). Constructing a functor
+ * draws a new random seed so a map can pick a new hash function
+ * on rehash by assigning a freshly constructed functor. A capacity
+ * policy rounds the table capacity and maps a 64-bit hash to a slot.
+ */
+typedef unsigned long long uint64;
+typedef unsigned int Index;
+
+/**
+ * Strong 64-bit integer mixer (the MurmurHash3 finalizer).
+ * Every input bit affects every output bit.
+ * @param h The value to mix
+ * @return The mixed value
+ */
+inline uint64 MixBits(uint64 h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+/**
+ * Multiplies a and b and folds the 128-bit product
+ * @return The low half of a * b xor the high half
+ */
+inline uint64 MulFold(uint64 a, uint64 b)
+{
+#ifdef __SIZEOF_INT128__
+	unsigned __int128 r = (unsigned __int128) a * b;
+	return (uint64) r ^ (uint64) (r >> 64);
+#else
+	//Schoolbook multiply on 32-bit halves
+	uint64 ha = a >> 32, hb = b >> 32, la = (unsigned int) a, lb = (unsigned int) b;
+	uint64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64 t = rl + (rm0 << 32);
+	uint64 c = t < rl;
+	uint64 lo = t + (rm1 << 32);
+	c += lo < t;
+	uint64 hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+	return lo ^ hi;
+#endif
+}
+
+//Reads 8, 4 or 1 to 3 bytes (little endian) from p
+inline uint64 Read8(const unsigned char* p) { uint64 v; memcpy(&v, p, 8); return v; }
+inline uint64 Read4(const unsigned char* p) { unsigned int v; memcpy(&v, p, 4); return v; }
+inline uint64 Read3(const unsigned char* p, size_t n)
+{
+	return ((uint64) p[0] << 16) | ((uint64) p[n >> 1] << 8) | p[n - 1];
+}
+
+/**
+ * Fast byte hash in the style of wyhash. Input is consumed
+ * 16 or 48 bytes at a time, each pair of words combined with
+ * one 64x64->128-bit multiply.
+ * @param key The bytes to hash
+ * @param len The number of bytes
+ * @param seed The seed
+ * @return The 64-bit hash
+ */
+inline uint64 HashBytes(const void* key, size_t len, uint64 seed)
+{
+	const static uint64 P0 = 0xa0761d6478bd642fULL, P1 = 0xe7037ed1a0b428dbULL;
+	const static uint64 P2 = 0x8ebc6af09c88c6e3ULL, P3 = 0x589965cc75374cc3ULL;
+	const unsigned char* p = (const unsigned char*) key;
+	seed ^= MulFold(seed ^ P0, P1);
+	uint64 a, b;
+	if(len <= 16)
+	{	//Short keys; overlapping reads cover all bytes
+		if(len >= 4)
+		{
+			size_t o = (len >> 3) << 2;
+			a = (Read4(p) << 32) | Read4(p + o);
+			b = (Read4(p + len - 4) << 32) | Read4(p + len - 4 - o);
+		}
+		else if(len > 0)
+		{
+			a = Read3(p, len);
+			b = 0;
+		}
+		else
+			a = b = 0;
+	}
+	else
+	{
+		size_t i = len;
+		if(i > 48)
+		{	//Three independent lanes for long keys
+			uint64 s1 = seed, s2 = seed;
+			do
+			{
+				seed = MulFold(Read8(p) ^ P1, Read8(p + 8) ^ seed);
+				s1 = MulFold(Read8(p + 16) ^ P2, Read8(p + 24) ^ s1);
+				s2 = MulFold(Read8(p + 32) ^ P3, Read8(p + 40) ^ s2);
+				p += 48;
+				i -= 48;
+			} while(i > 48);
+			seed ^= s1 ^ s2;
+		}
+		while(i > 16)
+		{
+			seed = MulFold(Read8(p) ^ P1, Read8(p + 8) ^ seed);
+			p += 16;
+			i -= 16;
+		}
+		//Last 16 bytes; may overlap the previous block
+		a = Read8(p + i - 16);
+		b = Read8(p + i - 8);
+	}
+	return MulFold(P1 ^ len, MulFold(a ^ P1, b ^ seed));
+}
+
+//Draws a random 64-bit seed
+inline uint64 RandomSeed()
+{
+	return ((uint64) rand() << 42) ^ ((uint64) rand() << 21) ^ (uint64) rand();
+}
+
+/**
+ * Hashes integers and enums of up to 64 bits with MixBits
+ */
+template <typename T>
+typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value) && sizeof(T) <= 8, uint64>::type
+HashKey(const T& k, uint64 seed)
+{
+	return MixBits((uint64) k ^ seed);
+}
+
+/**
+ * Hashes floating point values. Values are widened or
+ * narrowed to a double so padding bytes of long double are
+ * never read, and -0.0 hashes the same as 0.0
+ */
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value, uint64>::type
+HashKey(const T& k, uint64 seed)
+{
+	double d = k == 0 ? 0.0 : (double) k;
+	uint64 v;
+	memcpy(&v, &d, sizeof(v));
+	return MixBits(v ^ seed);
+}
+
+/**
+ * Hashes the bytes of other trivially copyable types such as
+ * 128-bit integers and POD structs. The type must not have
+ * padding, otherwise equal keys may hash differently
+ */
+template <typename T>
+typename std::enable_if<!std::is_arithmetic<T>::value && !std::is_enum<T>::value && std::is_trivially_copyable<T>::value, uint64>::type
+HashKey(const T& k, uint64 seed)
+{
+	return HashBytes(&k, sizeof(T), seed);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value && (sizeof(T) > 8), uint64>::type
+HashKey(const T& k, uint64 seed)
+{
+	return HashBytes(&k, sizeof(T), seed);
+}
+
+//Hashes the characters of a string
+inline uint64 HashKey(const std::string& k, uint64 seed)
+{
+	return HashBytes(k.data(), k.size(), seed);
+}
+
+/**
+ * The default hash functor. Uses a strong integer
+ * mixer for integral keys and HashBytes for strings
+ * and other trivially copyable keys.
+ */
+template <typename T>
+class DefaultHash
+{
+public:
+	DefaultHash() { seed = RandomSeed(); }
+	uint64 operator()(const T& k) const { return HashKey(k, seed); }
+private:
+	uint64 seed;
+};
+
+/**
+ * The multiplicative hash a * k + b with random
+ * a and b originally used by HashMap. Only for
+ * integral keys; kept for comparison.
+ */
+template <typename T>
+class MultHash
+{
+public:
+	MultHash()
+	{
+		a = (unsigned int) rand();
+		b = (unsigned int) rand();
+	}
+	uint64 operator()(const T& k) const { return a * (uint64) k + b; }
+private:
+	uint64 a, b;
+};
+
+/**
+ * Capacity policy that allows any capacity and
+ * reduces hashes with the modulo operator
+ */
+class ModCapacity
+{
+public:
+	/**
+	 * Rounds a requested capacity to one the policy supports
+	 * @param c The requested capacity
+	 * @return The capacity to use
+	 */
+	static unsigned int Round(unsigned int c) { return c > 0 ? c : 1; }
+
+	//Sets the capacity; c must come from Round
+	void Resize(unsigned int c) { max = c; }
+
+	//The home slot of hash h
+	Index Home(uint64 h) const { return (Index) (h % max); }
+
+	//The slot after j
+	Index Next(Index j) const { return (j + 1) % max; }
+
+	//The number of slots from slot i forward to slot j; no
+	//sum may pass 2^32 as max can be close to it
+	Index Dist(Index i, Index j) const { return j >= i ? j - i : j + (max - i); }
+private:
+	unsigned int max;
+};
+
+/**
+ * Capacity policy that rounds the capacity up to a power
+ * of 2. Hashes are reduced with Fibonacci (multiply-shift)
+ * hashing, which takes the top bits of h times 2^64 / phi,
+ * and slots wrap with a mask; no division is needed.
+ */
+class Pow2Capacity
+{
+public:
+	//Largest capacity; the next power of 2 does not fit in 32 bits
+	const static unsigned int MAX_CAPC = 2147483648U;
+
+	/**
+	 * Rounds a requested capacity to one the policy supports
+	 * @param c The requested capacity
+	 * @return The smallest power of 2 >= c (at least 2)
+	 * or MAX_CAPC if c is larger
+	 */
+	static unsigned int Round(unsigned int c)
+	{
+		unsigned int r = 2;
+		while(r < c && r < MAX_CAPC)
+			r *= 2;
+		return r;
+	}
+
+	//Sets the capacity; c must come from Round
+	void Resize(unsigned int c)
+	{
+		mask = c - 1;
+		shift = 64;
+		while(c > 1)
+		{
+			c /= 2;
+			--shift;
+		}
+	}
+
+	//The home slot of hash h
+	Index Home(uint64 h) const { return (Index) ((h * 11400714819323198485ULL) >> shift); }
+
+	//The slot after j
+	Index Next(Index j) const { return (j + 1) & mask; }
+
+	//The number of slots from slot i forward to slot j
+	Index Dist(Index i, Index j) const { return (j - i) & mask; }
+private:
+	unsigned int mask, shift;
+};
+#endif
@@ -1,18 +1,20 @@
 #ifndef HASHMAP_H
 #define HASHMAP_H
-#include <cstdlib>
+#include <cstddef>
+#include "Hash.h"
 typedef unsigned int Index;
 
 /**
  * A map implementation that uses a  hash table
- * with a multiplicative hash function internally. 
+ * with linear probing internally. Hash is the hash
+ * functor type and Capc the capacity policy; see Hash.h.
+ * Keys, values and slot occupancy are kept in separate
+ * arrays so probing only touches keys and the bitmap.
  */
-template <typename T1, typename T2>
+template <typename T1, typename T2, typename Hash = DefaultHash<T1>, typename Capc = Pow2Capacity>
 class HashMap : public Map<T1, T2>
-{	//Typedef to access Map's KeyValue pair
-	//Necessary only in g++
-	typedef typename Map<T1, T2>::KeyValue KeyValue;
-public:	
+{
+public:
 	/**
 	* Attempts to erase the (key, value) pair
 	* with key  = k. The int ELE_DNE is thrown
@@ -21,85 +23,151 @@ public:
 	*/
 	virtual void Erase(const T1& k)
 	{
-		Index i = F(k);
-		Index j = i;
-		while(true)
-		{	//Loop until key is found
-			if(arr[j].open) //Opening found; key d.n.e.
-				throw this->ELE_DNE;
-			else if(arr[j].key == k)
-			{//Found it
-				arr[j].open = true;
-				Rehash(max);
-				return;
+		Index j;
+		if(cur.Locate(k, j))
+			cur.Remove(j);
+		else if(old.keys != NULL && old.Locate(k, j))
+			old.Remove(j);
+		else
+			throw this->ELE_DNE;
+		if(old.keys != NULL)
+			Migrate(STEP);
+	}
+
+	/**
+	* Finds the corresponding value for a given
+	* key without throwing
+	* @param k Is the key to search for
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
+	*/
+	virtual T2* TryFind(const T1& k) const
+	{
+		Index j;
+		if(cur.Locate(k, j))
+			return &cur.vals[j];
+		//Key may not have been migrated yet
+		if(old.keys != NULL && old.Locate(k, j))
+			return &old.vals[j];
+		return NULL;
+	}
+
+	/**
+	* Finds the values for a batch of keys. The home
+	* slots of up to BATCH keys are prefetched before
+	* any of them is probed so the cache misses overlap
+	* @param keys The keys to search for
+	* @param num The number of keys
+	* @param out Output array; out[i] points to the value
+	* of keys[i] or is NULL if keys[i] is not in the map
+	*/
+	void FindMany(const T1* keys, size_t num, T2** out) const
+	{
+		Index home[BATCH];
+		for(size_t s = 0; s < num; s += BATCH)
+		{
+			size_t e = num - s < BATCH ? num - s : BATCH;
+			for(size_t i = 0; i < e; ++i)
+			{
+				home[i] = cur.Home(keys[s + i]);
+				Prefetch(cur.used + home[i] / 64, false);
+				Prefetch(cur.keys + home[i], false);
+			}
+			for(size_t i = 0; i < e; ++i)
+			{
+				out[s + i] = NULL;
+				for(Index j = home[i]; !cur.Open(j); j = cur.cp.Next(j))
+				{
+					if(cur.keys[j] == keys[s + i])
+					{
+						out[s + i] = &cur.vals[j];
+						break;
+					}
+				}
+				Index j;
+				if(out[s + i] == NULL && old.keys != NULL && old.Locate(keys[s + i], j))
+					out[s + i] = &old.vals[j];
 			}
-			j = (j + 1) % max;
-			if(j == i)	//Check to see if all values searched
-				throw this->ELE_DNE;
 		}
 	}
 
 	/**
-	* Attempts to find the corresponding value
-	* for a given key. The int ELE_DNE is thrown
-	* if the key is not in the map
-	* @param k Is the key to search for
-	* @return The value corresponding to k
+	* Adds a batch of (key, value) pairs to the map. The
+	* table is grown once for the whole batch and the home
+	* slots of up to BATCH keys are prefetched before any
+	* of them is inserted. A pending incremental resize
+	* is finished first. The int DUP_ELE is thrown if a
+	* key is already in the map; the pairs before it
+	* remain added
+	* @param keys The keys
+	* @param vals The values
+	* @param num The number of pairs
 	*/
-	virtual T2& Find(const T1& k) const
-	{	
-		Index i = F(k);
-		Index j = i;
-		while(true)
-		{	//Loop until open spot is found
-			if(arr[j].open) //Opening found; key d.n.e.
-				throw this->ELE_DNE;
-			else if(arr[j].key == k)	//Found it
-				return arr[j].val;
-			j = (j + 1) % max;
-			if(j == i)	//Check to see if all values searched
-				throw this->ELE_DNE;
+	void PutMany(const T1* keys, const T2* vals, size_t num)
+	{
+		if(old.keys != NULL)
+			Migrate(old.max);
+		unsigned int cap = cur.max;
+		while(cur.n + num > cap / 2)
+			cap *= 2;
+		if(cap != cur.max)
+			Rehash(cap);
+		Index home[BATCH];
+		for(size_t s = 0; s < num; s += BATCH)
+		{
+			size_t e = num - s < BATCH ? num - s : BATCH;
+			for(size_t i = 0; i < e; ++i)
+			{
+				home[i] = cur.Home(keys[s + i]);
+				Prefetch(cur.used + home[i] / 64, true);
+				Prefetch(cur.keys + home[i], true);
+			}
+			for(size_t i = 0; i < e; ++i)
+			{
+				Index j;
+				if(cur.Locate(keys[s + i], home[i], j))
+					throw this->DUP_ELE;
+				cur.Insert(keys[s + i], vals[s + i], j);
+			}
 		}
 	}
-	
+
 	/**
 	* Create a map with a default initial
 	* capacity
 	*/
 	HashMap()
 	{
-		max = DEF_CAPC;
-		n = 0;
-		arr = new KeyValue[max];
-		//Assign random values for a and b
-		a = (unsigned int) rand();
-		b = (unsigned int) rand();
+		cur.Init(DEF_CAPC);
+		cursor = 0;
+		incremental = false;
 	}
-	
+
 	/**
 	* Create a map with a initial capacity
-	* @param capc The initial capacity
+	* @param capc The initial capacity; rounded
+	* as required by the capacity policy
 	*/
 	HashMap(unsigned int capc)
 	{
-		max = capc;
-		n = 0;
-		arr = new KeyValue[max];
-		//Assign random values for a and b
-		a = (unsigned int) rand();
-		b = (unsigned int) rand();
+		cur.Init(capc);
+		cursor = 0;
+		incremental = false;
 	}
-	
+
 	//Copy constructor
 	HashMap(const HashMap& hm)
 	{
-		arr = NULL;
 		Copy(hm);
 	}
 
-	//Desctructor 
-	virtual ~HashMap() { delete [] arr; }
-	
+	//Desctructor
+	virtual ~HashMap()
+	{
+		cur.Free();
+		old.Free();
+	}
+
 	//Overloaded assignment operator
 	HashMap& operator=(const HashMap& hm)
 	{
@@ -108,40 +176,296 @@ public:
 	}
 
 	/**
-	* Adds a (key, value) pair to the map
+	* Adds a (key, value) pair to the map. The int
+	* DUP_ELE is thrown if the key is already in the map
 	* @param k Is the key
 	* @param v Is the value
 	*/
 	virtual void Put(const T1& k, const T2& v)
-	{	//Double size to prevent degraded performance
-		if(n == max / 2)
-			Rehash(max * 2);
-		Index i = F(k);
-		//Loop until a spot is found
-		while(true)
-		{	//Loop until open spot is found
-			if(arr[i].open) //Opening found; Put element
-			{	
-				arr[i] = KeyValue(k, v);
-				++n;
-				break;
-			}
-			i = (i + 1) % max;
-		}
+	{
+		bool found;
+		Place(k, v, found);
+		if(found)
+			throw this->DUP_ELE;
+	}
+
+	/**
+	* Finds the corresponding value for a given key.
+	* If the key is not in the map the pair (k, T2())
+	* is added first. The key is located only once
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	virtual T2& FindOrInsert(const T1& k)
+	{
+		bool found;
+		return *Place(k, T2(), found);
+	}
+
+	/**
+	* Sets the value for a given key, adding the
+	* (key, value) pair if the key is not in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Upsert(const T1& k, const T2& v)
+	{
+		bool found;
+		T2* p = Place(k, v, found);
+		if(found)
+			*p = v;
+	}
+
+	/**
+	 * Computes the distribution of probe lengths; hist[i]
+	 * is the number of elements stored i slots after their
+	 * home slot. Longer probes are counted in hist[len - 1]
+	 * @param hist Output array of len counts
+	 * @param len The length of hist
+	 */
+	void ProbeHistogram(unsigned int* hist, unsigned int len) const
+	{
+		for(unsigned int i = 0; i < len; ++i)
+			hist[i] = 0;
+		cur.ProbeHistogram(hist, len);
+		if(old.keys != NULL)
+			old.ProbeHistogram(hist, len);
+	}
+
+	/**
+	 * Turns incremental resizing on or off. When on, a
+	 * full table is not rebuilt at once; the old and new
+	 * tables are kept side by side and every Put or Erase
+	 * moves at least STEP slots over. Turning it off
+	 * finishes a pending resize
+	 * @param on True to resize incrementally
+	 */
+	void SetIncremental(bool on)
+	{
+		incremental = on;
+		if(!on && old.keys != NULL)
+			Migrate(old.max);
 	}
-	
+
 	/**
 	 * Returns the number of elements in the Map
 	 * @return: Number of elements in map object
 	 */
 	virtual unsigned int Size() const
 	{
-		return n;
+		return cur.n + (old.keys != NULL ? old.n : 0);
+	}
+
+	/**
+	 * Returns the number of bytes used by the tables
+	 * @return: Bytes allocated for keys, values and bitmaps
+	 */
+	size_t Bytes() const
+	{
+		return cur.Bytes() + (old.keys != NULL ? old.Bytes() : 0);
 	}
-	
+
 private:
 	//Default capacity of the underlying array
 	const static int DEF_CAPC = 10;
+	//Number of keys prefetched at once by the batch functions
+	const static size_t BATCH = 16;
+	//Minimum number of old slots migrated per operation
+	const static unsigned int STEP = 16;
+
+	/**
+	 * A linear probing table with its own hash function.
+	 * Bit j of used is set when slot j is full. The map
+	 * owns the arrays; copying a Table is shallow
+	 */
+	class Table
+	{
+	public:
+		Table() : keys(NULL), vals(NULL), used(NULL) { }
+
+		/**
+		 * Allocates empty arrays and picks
+		 * a new hash function
+		 * @param capc The capacity before rounding
+		 */
+		void Init(unsigned int capc)
+		{
+			max = Capc::Round(capc);
+			cp.Resize(max);
+			n = 0;
+			keys = new T1[max];
+			vals = new T2[max];
+			//All slots start open
+			used = new uint64[Words(max)]();
+			hf = Hash();
+		}
+
+		//Frees the arrays
+		void Free()
+		{
+			delete [] keys;
+			delete [] vals;
+			delete [] used;
+			keys = NULL;
+			vals = NULL;
+			used = NULL;
+		}
+
+		//Replaces the arrays with copies of themselves
+		void Clone()
+		{
+			const T1* k = keys;
+			const T2* v = vals;
+			const uint64* u = used;
+			keys = new T1[max];
+			vals = new T2[max];
+			used = new uint64[Words(max)];
+			for(Index i = 0; i < Words(max); ++i)
+				used[i] = u[i];
+			for(Index i = 0; i < max; ++i)
+			{
+				if(Open(i))
+					continue;
+				keys[i] = k[i];
+				vals[i] = v[i];
+			}
+		}
+
+		//The number of bitmap words for c slots
+		static unsigned int Words(unsigned int c) { return (c + 63) / 64; }
+
+		//True if slot j is open
+		bool Open(Index j) const { return !((used[j / 64] >> (j % 64)) & 1); }
+
+		//Marks slot j full or open
+		void Fill(Index j) { used[j / 64] |= 1ULL << (j % 64); }
+		void Clear(Index j) { used[j / 64] &= ~(1ULL << (j % 64)); }
+
+		//The number of bytes allocated for the arrays
+		size_t Bytes() const
+		{
+			return (size_t) max * (sizeof(T1) + sizeof(T2)) + Words(max) * sizeof(uint64);
+		}
+
+		//The home slot of key k
+		Index Home(const T1& k) const
+		{
+			return cp.Home(hf(k));
+		}
+
+		/**
+		 * Finds the slot holding key k
+		 * @param k The key to search for
+		 * @param j Output variable of the slot of k
+		 * @return True if the key is found false otherwise
+		 */
+		bool Locate(const T1& k, Index& j) const
+		{
+			return Locate(k, Home(k), j);
+		}
+
+		/**
+		 * Finds the slot holding key k. If k is not
+		 * in the table j is the open slot that ended
+		 * the search, where k would be inserted
+		 * @param k The key to search for
+		 * @param i The home slot of k
+		 * @param j Output variable of the slot of k
+		 * @return True if the key is found false otherwise
+		 */
+		bool Locate(const T1& k, Index i, Index& j) const
+		{
+			j = i;
+			while(true)
+			{	//Loop until open spot is found
+				if(Open(j)) //Opening found; key d.n.e.
+					return false;
+				else if(keys[j] == k)	//Found it
+					return true;
+				j = cp.Next(j);
+				if(j == i)	//Check to see if all values searched
+					return false;
+			}
+		}
+
+		/**
+		 * Puts a pair in the first open slot
+		 * at or after its home slot h
+		 */
+		void Insert(const T1& k, const T2& v, Index h)
+		{
+			while(!Open(h))
+				h = cp.Next(h);
+			keys[h] = k;
+			vals[h] = v;
+			Fill(h);
+			++n;
+		}
+
+		/**
+		* Opens slot j using backward-shift deletion.
+		* Any element further along the cluster whose
+		* probe sequence passes through the hole is moved
+		* back so that searches never stop early at it
+		* @param j The index of the slot to open
+		*/
+		void Remove(Index j)
+		{
+			Clear(j);
+			--n;
+			Index k = cp.Next(j);
+			while(!Open(k))
+			{	//Distance from the home slot of keys[k] to j and k
+				Index h = Home(keys[k]);
+				if(cp.Dist(h, j) < cp.Dist(h, k))
+				{	//keys[k] may move to j; k becomes the hole
+					keys[j] = keys[k];
+					vals[j] = vals[k];
+					Fill(j);
+					Clear(k);
+					j = k;
+				}
+				k = cp.Next(k);
+			}
+		}
+
+		//Adds the probe lengths of this table to hist
+		void ProbeHistogram(unsigned int* hist, unsigned int len) const
+		{
+			for(Index j = 0; j < max; ++j)
+			{
+				if(Open(j))
+					continue;
+				Index d = cp.Dist(Home(keys[j]), j);
+				++hist[d < len ? d : len - 1];
+			}
+		}
+
+		//The keys, values and occupancy bitmap
+		T1* keys;
+		T2* vals;
+		uint64* used;
+		//Number of elements and capcity
+		unsigned int n, max;
+		//The hash function and capacity policy
+		Hash hf;
+		Capc cp;
+	};
+
+	/**
+	 * Hints the CPU to load the cache line at p
+	 * @param p The address
+	 * @param w True if the line will be written
+	 */
+	static void Prefetch(const void* p, bool w)
+	{
+#ifdef __GNUC__
+		if(w)
+			__builtin_prefetch(p, 1);
+		else
+			__builtin_prefetch(p, 0);
+#endif
+	}
 
 	/**
 	 * Copies a HashMap
@@ -150,53 +474,122 @@ private:
 	{
 		if(this == &hm)
 			return;
-		a = hm.a;
-		b = hm.b;
-		max = hm.max;
-		n = hm.n;
-		delete [] arr;
-		arr = new KeyValue[max];
-		for(unsigned int i = 0; i < max; ++i)
-			arr[i] = hm.arr[i];
+		cur.Free();
+		old.Free();
+		cur = hm.cur;
+		old = hm.old;
+		cursor = hm.cursor;
+		incremental = hm.incremental;
+		cur.Clone();
+		if(old.keys != NULL)
+			old.Clone();
+	}
+
+	/**
+	 * Finds the value of key k, adding (k, v) if k is
+	 * not in the map. A missing key is put in the open
+	 * slot that ended the search; the search is only
+	 * repeated if the table has to grow first
+	 * @param k Is the key
+	 * @param v Is the value to add
+	 * @param found Output variable; true if k was
+	 * already in the map
+	 * @return The value corresponding to k
+	 */
+	T2* Place(const T1& k, const T2& v, bool& found)
+	{
+		Index j;
+		found = true;
+		if(cur.Locate(k, j))
+			return &cur.vals[j];
+		//Key may not have been migrated yet
+		Index o;
+		if(old.keys != NULL && old.Locate(k, o))
+			return &old.vals[o];
+		found = false;
+		if(cur.n == cur.max / 2)
+		{	//Double size to prevent degraded performance
+			if(old.keys != NULL)
+				Migrate(old.max);
+			if(incremental)
+				StartMigrate(cur.max * 2);
+			else
+				Rehash(cur.max * 2);
+			cur.Locate(k, j);
+		}
+		cur.Insert(k, v, j);
+		if(old.keys != NULL)
+			Migrate(STEP);
+		return &cur.vals[j];
 	}
-	
+
 	/**
 	* Resize the map's array
 	* @param The new size of the array
 	*/
 	void Rehash(unsigned int cap)
-	{	//Create a new hash function
-		a = (unsigned int) rand();
-		b = (unsigned int) rand();
-		//Create new array
-		int oldMax = max;
-		max = cap;
-		KeyValue* tmp = arr;
-		arr = new KeyValue[cap];
-		//Reset size
-		n = 0;
+	{	//Init creates a new hash function
+		Table tmp = cur;
+		cur.Init(cap);
 		//Recreate hash table
-		for(int i = 0; i < oldMax; ++i)
+		for(Index i = 0; i < tmp.max; ++i)
 		{
-			if(!tmp[i].open)
-				Put(tmp[i].key, tmp[i].val);
+			if(!tmp.Open(i))
+				cur.Insert(tmp.keys[i], tmp.vals[i], cur.Home(tmp.keys[i]));
 		}
-		//Delete the old array
-		delete [] tmp;
+		//Delete the old arrays
+		tmp.Free();
 	}
 
 	/**
-	* The hash function
-	* @param The element to be hashed
-	* @return The resulting hash index
-	*/
-	Index F(const T1& ele) const
+	 * Starts an incremental resize. The current table
+	 * becomes the old table and is drained by Migrate
+	 * @param cap The capacity of the new table
+	 */
+	void StartMigrate(unsigned int cap)
+	{
+		old = cur;
+		cur.Init(cap);
+		//Start right after an open slot
+		cursor = 0;
+		while(!old.Open(cursor))
+			cursor = old.cp.Next(cursor);
+		cursor = old.cp.Next(cursor);
+	}
+
+	/**
+	 * Moves at least cnt slots of the old table into the
+	 * current one. Migration only stops after an open slot so
+	 * whole clusters move; the rest of the old table stays a
+	 * valid linear probing table. The old table is freed once
+	 * it is empty
+	 * @param cnt The minimum number of slots to move
+	 */
+	void Migrate(unsigned int cnt)
 	{
-		return (a * ele + b) % max;
+		for(unsigned int i = 1; old.n > 0; ++i)
+		{
+			bool open = old.Open(cursor);
+			if(!open)
+			{
+				cur.Insert(old.keys[cursor], old.vals[cursor], cur.Home(old.keys[cursor]));
+				old.Clear(cursor);
+				--old.n;
+			}
+			cursor = old.cp.Next(cursor);
+			if(i >= cnt && open)
+				break;
+		}
+		if(old.n == 0)
+			old.Free();
 	}
-	//The hash table
-	KeyValue* arr;
-	//Number of elements, capcity, and hash function values
-	unsigned int n, max, a, b;
+
+	//The current table and the table being migrated
+	//from; old.keys is NULL when no resize is pending
+	Table cur, old;
+	//Next slot of the old table to migrate
+	Index cursor;
+	//True if resizes are incremental
+	bool incremental;
 };
 #endif
@@ -0,0 +1,109 @@
+#ifndef KARYNODE_H
+#define KARYNODE_H
+#include <cstddef>
+#include <limits>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/**
+ * A node of a static k-ary search tree: B sorted keys that fill
+ * a 64 byte cache line. Rank counts the keys of a node less than
+ * a given key, which is the child to descend into. Signed integers
+ * of 32 and 64 bits, float and double compare the whole node with
+ * two AVX2 instructions when built with AVX2; other types use a
+ * branchless loop.
+ */
+template <typename T, bool SI = std::numeric_limits<T>::is_integer &&
+	std::numeric_limits<T>::is_signed, size_t S = sizeof(T)>
+class KaryNode
+{
+public:
+	//Number of keys in a node
+	const static unsigned int B = sizeof(T) < 32 ? 64 / sizeof(T) : 2;
+
+	/**
+	 * Counts the keys less than k
+	 * @param node The B keys of the node
+	 * @param k The key
+	 * @return The number of keys less than k
+	 */
+	static unsigned int Rank(const T* node, const T& k)
+	{
+		unsigned int c = 0;
+		for(unsigned int i = 0; i < B; ++i)
+			c += node[i] < k;
+		return c;
+	}
+};
+
+#ifdef __AVX2__
+//32-bit signed integers; 16 keys per node
+template <typename T>
+class KaryNode<T, true, 4>
+{
+public:
+	const static unsigned int B = 16;
+
+	static unsigned int Rank(const T* node, const T& k)
+	{
+		__m256i kv = _mm256_set1_epi32((int) k);
+		__m256i a = _mm256_loadu_si256((const __m256i*) node);
+		__m256i b = _mm256_loadu_si256((const __m256i*) (node + 8));
+		unsigned int m = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(kv, a)));
+		m |= _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(kv, b))) << 8;
+		return _mm_popcnt_u32(m);
+	}
+};
+
+//64-bit signed integers; 8 keys per node
+template <typename T>
+class KaryNode<T, true, 8>
+{
+public:
+	const static unsigned int B = 8;
+
+	static unsigned int Rank(const T* node, const T& k)
+	{
+		__m256i kv = _mm256_set1_epi64x((long long) k);
+		__m256i a = _mm256_loadu_si256((const __m256i*) node);
+		__m256i b = _mm256_loadu_si256((const __m256i*) (node + 4));
+		unsigned int m = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(kv, a)));
+		m |= _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(kv, b))) << 4;
+		return _mm_popcnt_u32(m);
+	}
+};
+
+//Single precision floats; 16 keys per node
+template <>
+class KaryNode<float, false, 4>
+{
+public:
+	const static unsigned int B = 16;
+
+	static unsigned int Rank(const float* node, const float& k)
+	{
+		__m256 kv = _mm256_set1_ps(k);
+		unsigned int m = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(node), kv, _CMP_LT_OQ));
+		m |= _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(node + 8), kv, _CMP_LT_OQ)) << 8;
+		return _mm_popcnt_u32(m);
+	}
+};
+
+//Double precision floats; 8 keys per node
+template <>
+class KaryNode<double, false, 8>
+{
+public:
+	const static unsigned int B = 8;
+
+	static unsigned int Rank(const double* node, const double& k)
+	{
+		__m256d kv = _mm256_set1_pd(k);
+		unsigned int m = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(node), kv, _CMP_LT_OQ));
+		m |= _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(node + 4), kv, _CMP_LT_OQ)) << 4;
+		return _mm_popcnt_u32(m);
+	}
+};
+#endif
+#endif
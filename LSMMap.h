@@ -0,0 +1,386 @@
+#ifndef LSMMAP_H
+#define LSMMAP_H
+#include "Map.h"
+#include "AVLMap.h"
+#include "SearchTable.h"
+#include "BloomFilter.h"
+
+/**
+ * A write optimized ordered map in the style of a log-structured
+ * merge tree. New pairs go into a small AVLMap buffer. When the
+ * buffer holds bufSize keys it is flushed into an immutable sorted
+ * SearchTable run with a Bloom filter of its keys. Runs are merged
+ * tiered: as soon as FANOUT runs share a level they are merged into
+ * one run of the next level, so a pair is rewritten about once per
+ * level instead of shifting half of a SearchTable on every insert.
+ * Merges happen during the flush that triggers them. Erase writes
+ * a tombstone that hides the older versions of a key; tombstones
+ * are dropped when they are merged into the oldest run. A lookup
+ * searches the buffer and then the runs from newest to oldest,
+ * skipping runs whose filter rules the key out; the first version
+ * found wins. Put, Erase and Size need to know if a key is in the
+ * map, so every write starts with a lookup and values of keys that
+ * are in a run are changed in place.
+ * Hash is the hash functor type of the filters; see Hash.h.
+ */
+template <typename T1, typename T2, typename Hash = DefaultHash<T1> >
+class LSMMap : public Map<T1, T2>
+{
+public:
+	/**
+	* Attempts to erase the (key, value) pair
+	* with key  = k. The int ELE_DNE is thrown
+	* if the key is not in the map
+	* @param k Is the key of the pair to erase
+	*/
+	virtual void Erase(const T1& k)
+	{
+		Entry* e = Locate(k);
+		if(e == NULL || e->dead)
+			throw this->ELE_DNE;
+		--n;
+		if(nr == 0)
+		{	//No run can hold an older version
+			buf.Erase(k);
+			return;
+		}
+		Write(k).dead = true;
+	}
+
+	/**
+	* Finds the corresponding value for a given
+	* key without throwing
+	* @param k Is the key to search for
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
+	*/
+	virtual T2* TryFind(const T1& k) const
+	{
+		Entry* e = Locate(k);
+		return e == NULL || e->dead ? NULL : &e->val;
+	}
+
+	/**
+	* Create a map
+	* @param bufSize The number of keys the buffer
+	* holds before it is flushed into a run
+	*/
+	LSMMap(unsigned int bufSize = DEF_BUF)
+	{
+		bufMax = bufSize > 0 ? bufSize : 1;
+		n = nr = 0;
+	}
+
+	//Copy constructor
+	LSMMap(const LSMMap& lm)
+	{
+		n = nr = 0;
+		Copy(lm);
+	}
+
+	//Destructor
+	virtual ~LSMMap()
+	{
+		FreeRuns(0);
+	}
+
+	//Overloaded assignment operator
+	LSMMap& operator=(const LSMMap& lm)
+	{
+		Copy(lm);
+		return *this;
+	}
+
+	/**
+	* Adds a (key, value) pair to the map. The int
+	* DUP_ELE is thrown if the key is already in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Put(const T1& k, const T2& v)
+	{
+		Entry* e = Locate(k);
+		if(e != NULL && !e->dead)
+			throw this->DUP_ELE;
+		Add(k, v);
+	}
+
+	/**
+	* Finds the corresponding value for a given key.
+	* If the key is not in the map the pair (k, T2())
+	* is added first
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	virtual T2& FindOrInsert(const T1& k)
+	{
+		Entry* e = Locate(k);
+		if(e != NULL && !e->dead)
+			return e->val;
+		return Add(k, T2()).val;
+	}
+
+	/**
+	* Sets the value for a given key, adding the
+	* (key, value) pair if the key is not in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Upsert(const T1& k, const T2& v)
+	{
+		Entry* e = Locate(k);
+		if(e != NULL && !e->dead)
+			e->val = v;
+		else
+			Add(k, v);
+	}
+
+	/**
+	* Returns the number of elements in the Map
+	* @return: Number of elements in map object
+	*/
+	virtual unsigned int Size() const
+	{
+		return n;
+	}
+
+	/**
+	 * Flushes the buffer and merges all runs into one,
+	 * dropping every tombstone. Lookups then search a
+	 * single SearchTable
+	 */
+	void Compact()
+	{
+		Flush();
+		if(nr > 1)
+			Merge(0);
+	}
+
+	//Returns the number of runs
+	unsigned int Runs() const
+	{
+		return nr;
+	}
+
+private:
+	//Default number of keys in the buffer
+	const static unsigned int DEF_BUF = 1024;
+	//Number of runs of a level merged together
+	const static unsigned int FANOUT = 4;
+	//Largest number of runs; all runs are merged if reached
+	const static unsigned int MAX_RUNS = 64;
+	//Filter bits per key of a run
+	const static unsigned int FILTER_BITS = 10;
+
+	/**
+	 * A version of a value. A dead entry is a
+	 * tombstone left by Erase
+	 */
+	class Entry
+	{
+	public:
+		Entry() : val(), dead(false) { }
+		T2 val;
+		bool dead;
+	};
+
+	typedef SearchTable<T1, Entry> Run;
+
+	//Copies the pairs of a run or the buffer into arrays
+	class Collect
+	{
+	public:
+		Collect(T1* k, Entry* e, unsigned int& c, bool drop) : keys(k), ents(e), j(c), dropDead(drop) { }
+		void operator()(const T1& k, const Entry& e)
+		{
+			if(dropDead && e.dead)
+				return;
+			keys[j] = k;
+			ents[j++] = e;
+		}
+		T1* keys;
+		Entry* ents;
+		unsigned int& j;
+		bool dropDead;
+	};
+
+	/**
+	 * Finds the newest version of a key
+	 * @return The entry or NULL if no version exists
+	 */
+	Entry* Locate(const T1& k) const
+	{
+		Entry* e = buf.TryFind(k);
+		for(unsigned int i = nr; e == NULL && i > 0; --i)
+			if(filters[i - 1]->MayContain(k))
+				e = runs[i - 1]->TryFind(k);
+		return e;
+	}
+
+	/**
+	 * Returns the buffer entry of a key, flushing
+	 * the buffer first if it is full
+	 */
+	Entry& Write(const T1& k)
+	{
+		if(buf.Size() >= bufMax)
+			Flush();
+		return buf.FindOrInsert(k);
+	}
+
+	//Adds a key that is not in the map
+	Entry& Add(const T1& k, const T2& v)
+	{
+		Entry& e = Write(k);
+		e.val = v;
+		e.dead = false;
+		++n;
+		return e;
+	}
+
+	/**
+	 * Writes the buffer to a new run and merges runs
+	 * while the newest FANOUT share a level
+	 */
+	void Flush()
+	{
+		unsigned int m = buf.Size();
+		if(m == 0)
+			return;
+		T1* k = new T1[m];
+		Entry* e = new Entry[m];
+		//Tombstones hide nothing if there are no runs
+		unsigned int j = 0;
+		buf.ForEach(Collect(k, e, j, nr == 0));
+		buf = AVLMap<T1, Entry>();
+		AddRun(k, e, j, 0);
+		delete [] k;
+		delete [] e;
+		while(nr >= FANOUT && level[nr - FANOUT] == level[nr - 1])
+			Merge(nr - FANOUT);
+		if(nr == MAX_RUNS)
+			Merge(0);
+	}
+
+	/**
+	 * Merges runs first to nr - 1 into one run. For equal
+	 * keys the newest version is kept. Tombstones are
+	 * dropped if the oldest run is merged
+	 * @param first The oldest run to merge
+	 */
+	void Merge(unsigned int first)
+	{
+		unsigned int c = nr - first, total = 0;
+		T1** rk = new T1*[c];
+		Entry** re = new Entry*[c];
+		unsigned int* len = new unsigned int[c];
+		unsigned int* pos = new unsigned int[c];
+		for(unsigned int i = 0; i < c; ++i)
+		{
+			len[i] = runs[first + i]->Size();
+			pos[i] = 0;
+			rk[i] = new T1[len[i]];
+			re[i] = new Entry[len[i]];
+			runs[first + i]->ForEach(Collect(rk[i], re[i], pos[i], false));
+			pos[i] = 0;
+			total += len[i];
+		}
+		T1* k = new T1[total];
+		Entry* e = new Entry[total];
+		unsigned int j = 0;
+		while(true)
+		{	//The smallest key; the newest run wins ties
+			int b = -1;
+			for(unsigned int i = 0; i < c; ++i)
+				if(pos[i] < len[i] && (b < 0 || !(rk[b][pos[b]] < rk[i][pos[i]])))
+					b = (int) i;
+			if(b < 0)
+				break;
+			const T1 key = rk[b][pos[b]];
+			const Entry& ent = re[b][pos[b]];
+			if(first > 0 || !ent.dead)
+			{
+				k[j] = key;
+				e[j++] = ent;
+			}
+			//Skip the older versions
+			for(unsigned int i = 0; i < c; ++i)
+				if((int) i != b && pos[i] < len[i] && rk[i][pos[i]] == key)
+					++pos[i];
+			++pos[b];
+		}
+		unsigned int lvl = level[first] + 1;
+		FreeRuns(first);
+		AddRun(k, e, j, lvl);
+		for(unsigned int i = 0; i < c; ++i)
+		{
+			delete [] rk[i];
+			delete [] re[i];
+		}
+		delete [] rk;
+		delete [] re;
+		delete [] len;
+		delete [] pos;
+		delete [] k;
+		delete [] e;
+	}
+
+	/**
+	 * Adds a run as the newest one
+	 * @param k The keys in increasing order
+	 * @param e Their entries
+	 * @param m The number of keys; nothing is added if 0
+	 * @param lvl The level of the run
+	 */
+	void AddRun(const T1* k, const Entry* e, unsigned int m, unsigned int lvl)
+	{
+		if(m == 0)
+			return;
+		runs[nr] = new Run(k, e, m);
+		filters[nr] = new BloomFilter<T1, Hash>(m, FILTER_BITS);
+		for(unsigned int i = 0; i < m; ++i)
+			filters[nr]->Add(k[i]);
+		level[nr++] = lvl;
+	}
+
+	//Frees the runs from first on
+	void FreeRuns(unsigned int first)
+	{
+		for(unsigned int i = first; i < nr; ++i)
+		{
+			delete runs[i];
+			delete filters[i];
+		}
+		nr = first;
+	}
+
+	/**
+	 * Copies an LSMMap
+	 */
+	void Copy(const LSMMap& lm)
+	{
+		if(this == &lm)
+			return;
+		FreeRuns(0);
+		buf = lm.buf;
+		bufMax = lm.bufMax;
+		n = lm.n;
+		for(unsigned int i = 0; i < lm.nr; ++i)
+		{
+			runs[i] = new Run(*lm.runs[i]);
+			filters[i] = new BloomFilter<T1, Hash>(*lm.filters[i]);
+			level[i] = lm.level[i];
+		}
+		nr = lm.nr;
+	}
+
+	//The buffer of the newest versions
+	AVLMap<T1, Entry> buf;
+	//The runs from oldest to newest, their filters and levels
+	Run* runs[MAX_RUNS];
+	BloomFilter<T1, Hash>* filters[MAX_RUNS];
+	unsigned int level[MAX_RUNS];
+	//Number of elements, runs and buffer capacity
+	unsigned int n, nr, bufMax;
+};
+#endif
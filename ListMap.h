@@ -30,39 +30,66 @@ public:
 			}
 		}
 		//Key was not found; throw an exception
-		throw ELE_DNE;
+		throw this->ELE_DNE;
 	}
 	 
 	/**
-	* Attempts to find the corresponding value
-	* for a given key. The int ELE_DNE is thrown
-	* if the key is not in the map
+	* Finds the corresponding value for a given
+	* key without throwing
 	* @param k Is the key to search for
-	* @return The value corresponding to k
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
 	*/
-	T2& Find(const T1& k) const
+	T2* TryFind(const T1& k) const
 	{	//Search the list for the key
 		for(unsigned int i = 0; i < al.Size(); ++i)
 		{
 			if(al.Get(i).key == k)
-				return al.Get(i).value;
+				return &al.Get(i).value;
 		}
-		//Key was not found; throw an exception
-		throw ELE_DNE;
+		//Key was not found
+		return NULL;
 	}
 
 	/**
-	* Adds a (key, value) pair to the map
+	* Adds a (key, value) pair to the map. The int
+	* DUP_ELE is thrown if the key is already in the map
 	* @param k Is the key
 	* @param v Is the value
 	*/
 	void Put(const T1& k, const T2& v)
-	{	//Template type for KeyValue is implied
-		KeyValue tmp;
-		tmp.key = k;
-		tmp.value = v;
-		//Add the element to the list
-		al.Add(tmp);
+	{
+		bool found;
+		Place(k, v, found);
+		if(found)
+			throw this->DUP_ELE;
+	}
+
+	/**
+	* Finds the corresponding value for a given key.
+	* If the key is not in the map the pair (k, T2())
+	* is added first. The list is searched once
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	T2& FindOrInsert(const T1& k)
+	{
+		bool found;
+		return *Place(k, T2(), found);
+	}
+
+	/**
+	* Sets the value for a given key, adding the
+	* (key, value) pair if the key is not in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	void Upsert(const T1& k, const T2& v)
+	{
+		bool found;
+		T2* p = Place(k, v, found);
+		if(found)
+			*p = v;
 	}
 
 	/**
@@ -74,6 +101,30 @@ public:
 		return al.Size();
 	}
 private:
+	/**
+	 * Finds the value of key k, adding (k, v) at
+	 * the end of the list if k is not in the map
+	 * @param k Is the key
+	 * @param v Is the value to add
+	 * @param found Output variable; true if k was
+	 * already in the map
+	 * @return The value corresponding to k
+	 */
+	T2* Place(const T1& k, const T2& v, bool& found)
+	{	//Search the list for the key
+		T2* p = TryFind(k);
+		found = p != NULL;
+		if(found)
+			return p;
+		//Template type for KeyValue is implied
+		KeyValue tmp;
+		tmp.key = k;
+		tmp.value = v;
+		//Add the element to the list
+		al.Add(tmp);
+		return &al.Get(al.Size() - 1).value;
+	}
+
 	/**
 	 * Private class for specifying the (key, value)
 	 * pair. The template <typename T1, T2> is not needed
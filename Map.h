@@ -1,5 +1,6 @@
 #ifndef MAP_H
 #define MAP_H
+#include <cstddef>
 /**
  * A abstract class defining the interface
  * for the Map class. Two template parameters
@@ -21,6 +22,8 @@ public:
 	const static int ELE_DNE = -2468;
 	//Element exists already
 	const static int DUP_ELE = -1234;
+	//Map cannot be changed (read-only maps)
+	const static int READ_ONLY = -3579;
 
 	/**
 	* Attempts to erase the (key, value) pair
@@ -37,7 +40,33 @@ public:
 	* @param k Is the key to search for
 	* @return The value corresponding to k
 	*/
-	virtual T2& Find(const T1& k) const = 0;
+	virtual T2& Find(const T1& k) const
+	{
+		T2* v = TryFind(k);
+		if(v == NULL)
+			throw ELE_DNE;
+		return *v;
+	}
+
+	/**
+	* Finds the corresponding value for a given
+	* key. Nothing is thrown if the key is not in
+	* the map, so misses are cheap
+	* @param k Is the key to search for
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
+	*/
+	virtual T2* TryFind(const T1& k) const = 0;
+
+	/**
+	* Checks if a key is in the map
+	* @param k Is the key to search for
+	* @return True if k is in the map false otherwise
+	*/
+	bool Contains(const T1& k) const
+	{
+		return TryFind(k) != NULL;
+	}
 	
 	/**
 	* Returns the number of elements in the Map
@@ -46,12 +75,33 @@ public:
 	virtual unsigned int Size() const = 0;
 	
 	/**
-	* Adds a (key, value) pair to the map
+	* Adds a (key, value) pair to the map. The int
+	* DUP_ELE is thrown if the key is already in the map
 	* @param k Is the key
 	* @param v Is the value
 	*/
 	virtual void Put(const T1& k, const T2& v) = 0;
 
+	/**
+	* Finds the corresponding value for a given key.
+	* If the key is not in the map the pair (k, T2())
+	* is added first. The key is located only once
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	virtual T2& FindOrInsert(const T1& k) = 0;
+
+	/**
+	* Sets the value for a given key, adding the
+	* (key, value) pair if the key is not in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Upsert(const T1& k, const T2& v)
+	{
+		FindOrInsert(k) = v;
+	}
+
 protected:
 	/**
 	 * Protected class for specifying the (key, value)
@@ -0,0 +1,343 @@
+#ifndef MAPPEDTABLE_H
+#define MAPPEDTABLE_H
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Map.h"
+#include "SearchTable.h"
+
+/**
+ * A read-only view of a sorted table stored in a file. Write
+ * saves a SearchTable; the constructor maps the file into memory
+ * with mmap, so opening takes O(1) no matter the size of the table
+ * and pages are read on first use and shared by every process that
+ * maps the same file. Find, LowerBound and Range search the mapped
+ * keys in place. Keys and values must be trivially copyable and
+ * the file is only read by a build with the same sizes and byte
+ * order. Values may be changed through Find and TryFind; the
+ * mapping is private so changes are never written to the file.
+ * Put, FindOrInsert of a new key and Erase of a stored key throw
+ * READ_ONLY. Uses POSIX mmap.
+ *
+ * File format, version 1. All offsets are in bytes from the
+ * start of the file and every section starts on a PAGE boundary:
+ *   0:      Header (below), padded to PAGE bytes
+ *   keyOff: n keys in increasing order
+ *   valOff: n values; value i belongs to key i
+ */
+template <typename T1, typename T2>
+class MappedTable : public Map<T1, T2>
+{
+	static_assert(std::is_trivially_copyable<T1>::value && std::is_trivially_copyable<T2>::value,
+		"MappedTable needs trivially copyable keys and values");
+public:
+	//Thrown if the file cannot be read, written or mapped
+	//or is not a table of this type
+	const static int BAD_FILE = -8644;
+	//Current version of the file format
+	const static unsigned int VERSION = 1;
+	//Alignment of the sections
+	const static unsigned int PAGE = 4096;
+
+	/**
+	 * Writes a SearchTable to a file in any layout. The
+	 * int BAD_FILE is thrown if the file cannot be written
+	 * @param fn The file name
+	 * @param st The table
+	 */
+	static void Write(const char* fn, const SearchTable<T1, T2>& st)
+	{
+		std::ofstream out(fn, std::ios::binary | std::ios::trunc);
+		if(!out)
+			throw BAD_FILE;
+		Header h;
+		memset(&h, 0, sizeof(h));
+		memcpy(h.magic, Magic(), sizeof(h.magic));
+		h.version = VERSION;
+		h.page = PAGE;
+		h.keySize = sizeof(T1);
+		h.valSize = sizeof(T2);
+		h.n = st.Size();
+		h.keyOff = PAGE;
+		h.valOff = Align(h.keyOff + h.n * sizeof(T1));
+		h.size = Align(h.valOff + h.n * sizeof(T2));
+		out.write((const char*) &h, sizeof(h));
+		Pad(out, PAGE - sizeof(h));
+		st.ForEach(WriteKey(out));
+		Pad(out, h.valOff - h.keyOff - h.n * sizeof(T1));
+		st.ForEach(WriteVal(out));
+		Pad(out, h.size - h.valOff - h.n * sizeof(T2));
+		out.close();
+		if(!out)
+			throw BAD_FILE;
+	}
+
+	/**
+	* Keys cannot be removed. The int ELE_DNE is thrown
+	* if the key is not in the map and READ_ONLY otherwise
+	* @param k Is the key of the pair to erase
+	*/
+	virtual void Erase(const T1& k)
+	{
+		if(TryFind(k) == NULL)
+			throw this->ELE_DNE;
+		throw this->READ_ONLY;
+	}
+
+	/**
+	* Finds the corresponding value for a given
+	* key without throwing
+	* @param k Is the key to search for
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
+	*/
+	virtual T2* TryFind(const T1& k) const
+	{
+		unsigned int i = Lower(k);
+		return i < n && keys[i] == k ? &vals[i] : NULL;
+	}
+
+	/**
+	 * Maps a file written by Write. The int BAD_FILE is
+	 * thrown if it cannot be mapped or its header does not
+	 * match this type
+	 * @param fn The file name
+	 */
+	MappedTable(const char* fn)
+	{
+		int fd = open(fn, O_RDONLY);
+		if(fd < 0)
+			throw BAD_FILE;
+		struct stat sb;
+		if(fstat(fd, &sb) != 0 || (size_t) sb.st_size < sizeof(Header))
+		{
+			close(fd);
+			throw BAD_FILE;
+		}
+		bytes = (size_t) sb.st_size;
+		//Private so values can change without touching the file
+		mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if(mem == MAP_FAILED)
+			throw BAD_FILE;
+		if(!Valid((const Header*) mem))
+		{
+			munmap(mem, bytes);
+			throw BAD_FILE;
+		}
+		const Header* h = (const Header*) mem;
+		n = (unsigned int) h->n;
+		keys = (T1*) ((char*) mem + h->keyOff);
+		vals = (T2*) ((char*) mem + h->valOff);
+	}
+
+	//Destructor; unmaps the file
+	virtual ~MappedTable()
+	{
+		munmap(mem, bytes);
+	}
+
+	/**
+	* Keys cannot be added. The int DUP_ELE is thrown
+	* if the key is already in the map and READ_ONLY
+	* otherwise
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Put(const T1& k, const T2&)
+	{
+		if(TryFind(k) != NULL)
+			throw this->DUP_ELE;
+		throw this->READ_ONLY;
+	}
+
+	/**
+	* Finds the corresponding value for a given key.
+	* The int READ_ONLY is thrown if the key is not
+	* in the map
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	virtual T2& FindOrInsert(const T1& k)
+	{
+		T2* v = TryFind(k);
+		if(v == NULL)
+			throw this->READ_ONLY;
+		return *v;
+	}
+
+	/**
+	* Finds the first pair with a key not less than k
+	* @param k Is the key to search for
+	* @param key Output variable of the key of the pair
+	* @return A pointer to the value of the pair or NULL
+	* if every key is less than k
+	*/
+	T2* LowerBound(const T1& k, T1& key) const
+	{
+		unsigned int i = Lower(k);
+		if(i == n)
+			return NULL;
+		key = keys[i];
+		return &vals[i];
+	}
+
+	/**
+	* Finds the first pair with a key greater than k
+	* @param k Is the key to search for
+	* @param key Output variable of the key of the pair
+	* @return A pointer to the value of the pair or NULL
+	* if no key is greater than k
+	*/
+	T2* UpperBound(const T1& k, T1& key) const
+	{
+		unsigned int i = Lower(k);
+		if(i < n && keys[i] == k)
+			++i;
+		if(i == n)
+			return NULL;
+		key = keys[i];
+		return &vals[i];
+	}
+
+	/**
+	* Calls f(key, val) for every pair with lo <= key < hi
+	* in key order
+	* @param lo Is the smallest key of the range
+	* @param hi Is the end of the range; not included
+	* @param f Is the function to call
+	* @return The number of pairs visited
+	*/
+	template <typename F>
+	unsigned int Range(const T1& lo, const T1& hi, F f) const
+	{
+		unsigned int i = Lower(lo), c = 0;
+		for(; i < n && keys[i] < hi; ++i, ++c)
+			f(keys[i], vals[i]);
+		return c;
+	}
+
+	/**
+	* Returns the number of elements in the Map
+	* @return: Number of elements in map object
+	*/
+	virtual unsigned int Size() const
+	{
+		return n;
+	}
+
+	//The keys in increasing order
+	const T1* Keys() const { return keys; }
+
+	//The values; value i belongs to key i
+	const T2* Values() const { return vals; }
+
+	//Returns the size of the mapping in bytes
+	size_t Bytes() const { return bytes; }
+
+private:
+	//Identifies a table file; 8 bytes
+	static const char* Magic() { return "CDSTABLE"; }
+
+	//The start of the file
+	class Header
+	{
+	public:
+		char magic[8];
+		unsigned int version;
+		unsigned int page;
+		unsigned int keySize;
+		unsigned int valSize;
+		unsigned long long n;
+		unsigned long long keyOff;
+		unsigned long long valOff;
+		unsigned long long size;
+	};
+
+	//Writes the keys or the values of a table in key order
+	class WriteKey
+	{
+	public:
+		WriteKey(std::ofstream& o) : out(o) { }
+		void operator()(const T1& k, const T2&) { out.write((const char*) &k, sizeof(T1)); }
+	private:
+		std::ofstream& out;
+	};
+
+	class WriteVal
+	{
+	public:
+		WriteVal(std::ofstream& o) : out(o) { }
+		void operator()(const T1&, const T2& v) { out.write((const char*) &v, sizeof(T2)); }
+	private:
+		std::ofstream& out;
+	};
+
+	//The view cannot be copied
+	MappedTable(const MappedTable&);
+	MappedTable& operator=(const MappedTable&);
+
+	/**
+	 * Checks the header of a mapped file against this type
+	 * and the size of the mapping. Offsets are compared with
+	 * the mapping before any size is added to them and the
+	 * number of keys is compared with the room left after each
+	 * section start, so no sum or product can overflow
+	 */
+	bool Valid(const Header* h) const
+	{
+		if(memcmp(h->magic, Magic(), sizeof(h->magic)) != 0 || h->version != VERSION ||
+			h->keySize != sizeof(T1) || h->valSize != sizeof(T2) || h->n > 0xffffffffULL)
+			return false;
+		//The sections follow the header and stay in the mapping
+		if(h->size > bytes || h->keyOff < PAGE || h->keyOff % PAGE != 0 || h->valOff % PAGE != 0 ||
+			h->keyOff > h->valOff || h->valOff > h->size)
+			return false;
+		return h->n <= (h->valOff - h->keyOff) / sizeof(T1) && h->n <= (h->size - h->valOff) / sizeof(T2);
+	}
+
+	//Rounds up to a multiple of PAGE
+	static unsigned long long Align(unsigned long long x)
+	{
+		return (x + PAGE - 1) / PAGE * PAGE;
+	}
+
+	//Writes c zero bytes
+	static void Pad(std::ofstream& out, unsigned long long c)
+	{
+		char z[PAGE] = { };
+		out.write(z, (std::streamsize) c);
+	}
+
+	//The index of the first key not less than k
+	unsigned int Lower(const T1& k) const
+	{
+		unsigned int lo = 0, len = n;
+		while(len > 0)
+		{
+			unsigned int h = len / 2;
+			if(keys[lo + h] < k)
+			{
+				lo += h + 1;
+				len -= h + 1;
+			}
+			else
+				len = h;
+		}
+		return lo;
+	}
+
+	//The mapping and its size
+	void* mem;
+	size_t bytes;
+	//Number of elements
+	unsigned int n;
+	//The keys and values in the mapping
+	T1* keys;
+	T2* vals;
+};
+#endif
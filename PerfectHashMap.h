@@ -0,0 +1,395 @@
+#ifndef PERFECTHASHMAP_H
+#define PERFECTHASHMAP_H
+#include <cstring>
+#include "Map.h"
+#include "Hash.h"
+typedef unsigned int Index;
+
+/**
+ * An immutable map built from a fixed set of keys with a minimal
+ * perfect hash function in the style of PTHash. Keys are spread
+ * over buckets of about LAMBDA keys and every bucket stores a
+ * 16-bit pilot chosen at construction so that its keys land in
+ * free slots; about 3.5 bits of index per key. A lookup hashes the
+ * key once, reads the pilot of its bucket and compares the key of
+ * exactly one (key, value) pair. Slots past the n-th (the table
+ * has 1% slack to keep the pilot search short) are remapped to
+ * the free slots below n, so the pairs fill an array of exactly
+ * n entries. Values may be changed through Find and TryFind but
+ * keys cannot be added or removed: Put, FindOrInsert of a new key
+ * and Erase of a stored key throw READ_ONLY.
+ * Hash is the hash functor type; see Hash.h.
+ */
+template <typename T1, typename T2, typename Hash = DefaultHash<T1> >
+class PerfectHashMap : public Map<T1, T2>
+{
+	//Typedef to access Map's KeyValue pair
+	typedef typename Map<T1, T2>::KeyValue KeyValue;
+public:
+	//Thrown if no perfect hash function was found
+	const static int NO_PHF = -8643;
+
+	/**
+	* Keys cannot be removed. The int ELE_DNE is thrown
+	* if the key is not in the map and READ_ONLY otherwise
+	* @param k Is the key of the pair to erase
+	*/
+	virtual void Erase(const T1& k)
+	{
+		if(TryFind(k) == NULL)
+			throw this->ELE_DNE;
+		throw this->READ_ONLY;
+	}
+
+	/**
+	* Finds the corresponding value for a given
+	* key without throwing
+	* @param k Is the key to search for
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
+	*/
+	virtual T2* TryFind(const T1& k) const
+	{
+		if(n == 0)
+			return NULL;
+		uint64 h = hf(k);
+		Index p = Pos(h, pilots[Bucket(h)]);
+		if(p >= n)
+			p = remap[p - n];
+		KeyValue& kv = pairs[p];
+		return kv.key == k ? &kv.val : NULL;
+	}
+
+	//Create an empty map
+	PerfectHashMap()
+	{
+		Init();
+	}
+
+	/**
+	* Builds the map from arrays of keys and values.
+	* The int DUP_ELE is thrown if a key appears twice
+	* @param keys The keys
+	* @param vals The values; vals[i] belongs to keys[i]
+	* @param numEle The number of pairs
+	*/
+	PerfectHashMap(const T1* keys, const T2* vals, unsigned int numEle)
+	{
+		Init();
+		Build(keys, vals, numEle);
+	}
+
+	//Copy constructor
+	PerfectHashMap(const PerfectHashMap& pm)
+	{
+		Init();
+		Copy(pm);
+	}
+
+	//Destructor
+	virtual ~PerfectHashMap()
+	{
+		Free();
+	}
+
+	//Overloaded assignment operator
+	PerfectHashMap& operator=(const PerfectHashMap& pm)
+	{
+		Copy(pm);
+		return *this;
+	}
+
+	/**
+	* Keys cannot be added. The int DUP_ELE is thrown
+	* if the key is already in the map and READ_ONLY
+	* otherwise
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Put(const T1& k, const T2&)
+	{
+		if(TryFind(k) != NULL)
+			throw this->DUP_ELE;
+		throw this->READ_ONLY;
+	}
+
+	/**
+	* Finds the corresponding value for a given key.
+	* The int READ_ONLY is thrown if the key is not
+	* in the map
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	virtual T2& FindOrInsert(const T1& k)
+	{
+		T2* v = TryFind(k);
+		if(v == NULL)
+			throw this->READ_ONLY;
+		return *v;
+	}
+
+	/**
+	* Returns the number of elements in the Map
+	* @return: Number of elements in map object
+	*/
+	virtual unsigned int Size() const
+	{
+		return n;
+	}
+
+	/**
+	 * Returns the number of bytes used by the map
+	 * including the pairs and the hash function
+	 */
+	size_t Bytes() const
+	{
+		return sizeof(*this) + n * sizeof(KeyValue) + IndexBytes();
+	}
+
+	//Returns the number of bits of the hash function per key
+	double BitsPerKey() const
+	{
+		return n == 0 ? 0.0 : 8.0 * IndexBytes() / n;
+	}
+
+private:
+	//Average number of keys per bucket
+	const static unsigned int LAMBDA = 5;
+	//Number of keys per extra slot; about 1% slack
+	const static unsigned int SLACK = 100;
+	//Largest pilot
+	const static unsigned int MAX_PILOT = 65535;
+	//Number of hash functions tried before giving up
+	const static unsigned int MAX_SEEDS = 16;
+	//Fraction of hashes (out of 2^32) sent to the dense
+	//buckets; 60% of keys go to 30% of buckets
+	const static uint64 DENSE_KEYS = 2576980377ULL;
+
+	//Sets up an empty map
+	void Init()
+	{
+		n = m = nb = nd = 0;
+		pairs = NULL;
+		pilots = NULL;
+		remap = NULL;
+	}
+
+	//Frees all dynamic memory
+	void Free()
+	{
+		delete [] pairs;
+		delete [] pilots;
+		delete [] remap;
+		Init();
+	}
+
+	//Bytes used by the pilots and the remapped slots
+	size_t IndexBytes() const
+	{
+		return nb * sizeof(unsigned short) + (m - n) * sizeof(Index);
+	}
+
+	/**
+	 * Copies a PerfectHashMap
+	 */
+	void Copy(const PerfectHashMap& pm)
+	{
+		if(this == &pm)
+			return;
+		Free();
+		if(pm.n == 0)
+			return;
+		hf = pm.hf;
+		n = pm.n;
+		m = pm.m;
+		nb = pm.nb;
+		nd = pm.nd;
+		pairs = new KeyValue[n];
+		for(Index i = 0; i < n; ++i)
+			pairs[i] = pm.pairs[i];
+		pilots = new unsigned short[nb];
+		memcpy(pilots, pm.pilots, nb * sizeof(unsigned short));
+		remap = new Index[m - n];
+		memcpy(remap, pm.remap, (m - n) * sizeof(Index));
+	}
+
+	/**
+	 * The bucket of a hash. The top half of the hash picks
+	 * the dense or the sparse buckets and the bottom half
+	 * picks a bucket among them. Written without a branch as
+	 * the choice is random
+	 */
+	Index Bucket(uint64 h) const
+	{
+		bool dense = (h >> 32) < DENSE_KEYS;
+		Index first = dense ? 0 : nd;
+		uint64 num = dense ? nd : nb - nd;
+		return first + (Index) (((h & 0xffffffffULL) * num) >> 32);
+	}
+
+	/**
+	 * The slot in [0, m) of a hash given the pilot of its
+	 * bucket. h is already mixed so one multiply carries all
+	 * of its bits into the top half
+	 */
+	Index Pos(uint64 h, unsigned int pilot) const
+	{
+		uint64 x = (h ^ (pilot * 0x9e3779b97f4a7c15ULL)) * 0xc4ceb9fe1a85ec53ULL;
+		return (Index) (((x >> 32) * m) >> 32);
+	}
+
+	/**
+	 * Builds the map. New hash functions are drawn until
+	 * every bucket finds a pilot
+	 */
+	void Build(const T1* keys, const T2* vals, unsigned int num)
+	{
+		if(num == 0)
+			return;
+		n = num;
+		m = n + n / SLACK + 1;
+		nb = n / LAMBDA + 2;
+		nd = nb * 3 / 10 + 1;
+		uint64* h = new uint64[n];
+		Index* order = new Index[n];
+		Index* start = new Index[nb + 1];
+		unsigned char* taken = new unsigned char[m];
+		pilots = new unsigned short[nb];
+		remap = new Index[m - n];
+		int r = 0;
+		for(unsigned int s = 0; s < MAX_SEEDS && r == 0; ++s)
+		{
+			if(s > 0)
+				hf = Hash();
+			for(Index i = 0; i < n; ++i)
+				h[i] = hf(keys[i]);
+			r = Place(keys, h, order, start, taken);
+		}
+		if(r == 1)
+		{	//Put the pairs at the slots of their keys
+			pairs = new KeyValue[n];
+			for(Index i = 0; i < n; ++i)
+			{
+				Index p = Pos(h[i], pilots[Bucket(h[i])]);
+				pairs[p < n ? p : remap[p - n]] = KeyValue(keys[i], vals[i]);
+			}
+		}
+		delete [] h;
+		delete [] order;
+		delete [] start;
+		delete [] taken;
+		if(r == 1)
+			return;
+		Free();
+		if(r < 0)
+			throw this->DUP_ELE;
+		throw NO_PHF;
+	}
+
+	/**
+	 * Finds a pilot for each bucket, largest buckets first,
+	 * and remaps the taken slots past n to the free slots
+	 * below n
+	 * @param keys The keys
+	 * @param h The hashes of the keys
+	 * @param order Scratch space of n indices
+	 * @param start Scratch space of nb + 1 indices
+	 * @param taken Scratch space of m flags
+	 * @return 1 on success, 0 if the hash function does
+	 * not work and -1 if a key appears twice
+	 */
+	int Place(const T1* keys, const uint64* h, Index* order, Index* start, unsigned char* taken)
+	{	//Group the keys by bucket with a counting sort
+		memset(start, 0, (nb + 1) * sizeof(Index));
+		for(Index i = 0; i < n; ++i)
+			++start[Bucket(h[i]) + 1];
+		Index maxSize = 0;
+		for(Index b = 0; b < nb; ++b)
+		{
+			if(start[b + 1] > maxSize)
+				maxSize = start[b + 1];
+			start[b + 1] += start[b];
+		}
+		Index* fill = new Index[nb];
+		memcpy(fill, start, nb * sizeof(Index));
+		for(Index i = 0; i < n; ++i)
+			order[fill[Bucket(h[i])]++] = i;
+		//Order the buckets by size, largest first
+		Index* bySize = new Index[maxSize + 2];
+		memset(bySize, 0, (maxSize + 2) * sizeof(Index));
+		for(Index b = 0; b < nb; ++b)
+			++bySize[maxSize - (start[b + 1] - start[b]) + 1];
+		for(Index s = 0; s <= maxSize; ++s)
+			bySize[s + 1] += bySize[s];
+		for(Index b = 0; b < nb; ++b)
+			fill[bySize[maxSize - (start[b + 1] - start[b])]++] = b;
+		delete [] bySize;
+		memset(taken, 0, m);
+		memset(pilots, 0, nb * sizeof(unsigned short));
+		Index* pos = new Index[maxSize > 0 ? maxSize : 1];
+		int r = 1;
+		for(Index i = 0; i < nb && r == 1; ++i)
+		{
+			Index b = fill[i];
+			const Index* e = order + start[b];
+			Index s = start[b + 1] - start[b];
+			if(s == 0)
+				break;
+			//Keys with equal hashes always collide
+			for(Index j = 0; j < s && r == 1; ++j)
+				for(Index k = j + 1; k < s && r == 1; ++k)
+					if(h[e[j]] == h[e[k]])
+						r = keys[e[j]] == keys[e[k]] ? -1 : 0;
+			if(r != 1)
+				break;
+			r = 0;
+			for(unsigned int pilot = 0; pilot <= MAX_PILOT && r == 0; ++pilot)
+			{	//Take the slots one by one; undo on a collision
+				Index j = 0;
+				for(; j < s; ++j)
+				{
+					pos[j] = Pos(h[e[j]], pilot);
+					if(taken[pos[j]])
+						break;
+					taken[pos[j]] = 1;
+				}
+				if(j == s)
+				{
+					pilots[b] = (unsigned short) pilot;
+					r = 1;
+				}
+				else
+					while(j > 0)
+						taken[pos[--j]] = 0;
+			}
+		}
+		delete [] pos;
+		delete [] fill;
+		if(r != 1)
+			return r;
+		//Exactly as many slots past n are taken as are free below n
+		Index f = 0;
+		for(Index p = n; p < m; ++p)
+		{
+			remap[p - n] = 0;
+			if(!taken[p])
+				continue;
+			while(taken[f])
+				++f;
+			remap[p - n] = f++;
+		}
+		return 1;
+	}
+
+	//The (key, value) pairs; pairs[i] is at slot i
+	KeyValue* pairs;
+	//The pilot of each bucket
+	unsigned short* pilots;
+	//The slot below n used for each slot past n
+	Index* remap;
+	//Number of elements, slots, buckets and dense buckets
+	unsigned int n, m, nb, nd;
+	//The hash function
+	Hash hf;
+};
+#endif
@@ -10,6 +10,10 @@
 // ============================================================================
 #include <cstdlib>
 
+//Swaps x and y; defined below
+template <typename T>
+void Swap(T& x, T& y);
+
 // ====QuickSort============================================================
 // Desc:	a standard implementation of the classic mergesort algorithm.
 // Param 1:	a pointer to the array of integers to be sorted.
@@ -58,7 +62,7 @@ int Partition(T* a, int l, int r)
 	Swap(a[l], a[x]);
 	do
 	{
-		do i++; while(a[i] < p && i <= r);
+		do i++; while(i <= r && a[i] < p);
 		do j--; while(a[j] > p);
 		if(i < j)
 			Swap(a[i], a[j]);
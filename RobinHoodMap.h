@@ -0,0 +1,348 @@
+#ifndef ROBINHOODMAP_H
+#define ROBINHOODMAP_H
+#include "Hash.h"
+typedef unsigned int Index;
+
+/**
+ * A map implementation that uses a linear probing hash
+ * table with Robin Hood displacement. Each slot stores its
+ * distance from its home slot; an insert takes the slot of
+ * any element closer to home than itself. This keeps probe
+ * lengths short and even at high load, and lets a failed
+ * search stop as soon as it passes an element that is closer
+ * to home than the key being searched for. Hash is the hash
+ * functor type; see Hash.h.
+ */
+template <typename T1, typename T2, typename Hash = DefaultHash<T1> >
+class RobinHoodMap : public Map<T1, T2>
+{
+public:
+	/**
+	* Attempts to erase the (key, value) pair
+	* with key  = k. The int ELE_DNE is thrown
+	* if the key is not in the map
+	* @param k Is the key of the pair to erase
+	*/
+	virtual void Erase(const T1& k)
+	{
+		Index j;
+		if(!Locate(k, j))
+			throw this->ELE_DNE;
+		//Backward-shift deletion; move the rest of the
+		//cluster one slot closer to home
+		Index i = Next(j);
+		while(slots[i].dist > 1)
+		{
+			slots[j] = slots[i];
+			--slots[j].dist;
+			j = i;
+			i = Next(i);
+		}
+		slots[j].dist = 0;
+		--n;
+	}
+
+	/**
+	* Finds the corresponding value for a given
+	* key without throwing
+	* @param k Is the key to search for
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
+	*/
+	virtual T2* TryFind(const T1& k) const
+	{
+		Index j;
+		if(!Locate(k, j))
+			return NULL;
+		return &slots[j].val;
+	}
+
+	/**
+	* Create a map with a default initial
+	* capacity and load factor
+	*/
+	RobinHoodMap()
+	{
+		load = DEF_LOAD;
+		Init(DEF_CAPC);
+	}
+
+	/**
+	* Create a map with a initial capacity
+	* @param capc The initial capacity; at least 1
+	* @param lf The maximum load factor in percent;
+	* kept within 1 to 100
+	*/
+	RobinHoodMap(unsigned int capc, unsigned int lf = DEF_LOAD)
+	{
+		load = lf < 1 ? 1 : (lf > 100 ? 100 : lf);
+		Init(capc);
+	}
+
+	//Copy constructor
+	RobinHoodMap(const RobinHoodMap& rm)
+	{
+		slots = NULL;
+		Copy(rm);
+	}
+
+	//Destructor
+	virtual ~RobinHoodMap() { delete [] slots; }
+
+	//Overloaded assignment operator
+	RobinHoodMap& operator=(const RobinHoodMap& rm)
+	{
+		Copy(rm);
+		return *this;
+	}
+
+	/**
+	* Adds a (key, value) pair to the map. The int
+	* DUP_ELE is thrown if the key is already in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Put(const T1& k, const T2& v)
+	{
+		bool found;
+		Place(k, v, found);
+		if(found)
+			throw this->DUP_ELE;
+	}
+
+	/**
+	* Finds the corresponding value for a given key.
+	* If the key is not in the map the pair (k, T2())
+	* is added first. The key is located only once
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	virtual T2& FindOrInsert(const T1& k)
+	{
+		bool found;
+		return *Place(k, T2(), found);
+	}
+
+	/**
+	* Sets the value for a given key, adding the
+	* (key, value) pair if the key is not in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Upsert(const T1& k, const T2& v)
+	{
+		bool found;
+		T2* p = Place(k, v, found);
+		if(found)
+			*p = v;
+	}
+
+	/**
+	 * Returns the number of elements in the Map
+	 * @return: Number of elements in map object
+	 */
+	virtual unsigned int Size() const
+	{
+		return n;
+	}
+
+private:
+	/**
+	 * A (key, value) slot with the distance from its home
+	 * slot plus one. A distance of 0 marks an open slot
+	 */
+	class Slot
+	{
+	public:
+		Slot() { dist = 0; }
+		T1 key;
+		T2 val;
+		unsigned char dist;
+	};
+
+	//Default capacity of the underlying array
+	const static int DEF_CAPC = 10;
+	//Default maximum load factor in percent
+	const static unsigned int DEF_LOAD = 90;
+	//Longest allowed probe length
+	const static unsigned char MAX_DIST = 255;
+
+	/**
+	 * Allocates an empty table
+	 * @param capc The capacity; 0 is taken as 1
+	 */
+	void Init(unsigned int capc)
+	{
+		max = capc > 0 ? capc : 1;
+		n = 0;
+		slots = new Slot[max];
+		//Pick a new hash function
+		hf = Hash();
+	}
+
+	/**
+	 * Copies a RobinHoodMap
+	 */
+	void Copy(const RobinHoodMap& rm)
+	{
+		if(this == &rm)
+			return;
+		hf = rm.hf;
+		max = rm.max;
+		n = rm.n;
+		load = rm.load;
+		delete [] slots;
+		slots = new Slot[max];
+		for(Index i = 0; i < max; ++i)
+			slots[i] = rm.slots[i];
+	}
+
+	/**
+	 * Finds the slot holding key k
+	 * @param k The key to search for
+	 * @param j Output variable of the slot of k
+	 * @return True if the key is found false otherwise
+	 */
+	bool Locate(const T1& k, Index& j) const
+	{
+		unsigned int d;
+		return Locate(k, j, d);
+	}
+
+	/**
+	 * Finds the slot holding key k. If k is not in the
+	 * table the search stops at slot j, where k would be
+	 * inserted, with d its distance from home plus one
+	 * @param k The key to search for
+	 * @param j Output variable of the slot of k
+	 * @param d Output variable of the distance plus one
+	 * @return True if the key is found false otherwise
+	 */
+	bool Locate(const T1& k, Index& j, unsigned int& d) const
+	{
+		j = F(k);
+		for(d = 1; ; ++d)
+		{	//k would have displaced any element nearer home
+			if(slots[j].dist < d)
+				return false;
+			if(slots[j].key == k)
+				return true;
+			j = Next(j);
+		}
+	}
+
+	/**
+	 * Finds the value of key k, adding (k, v) if k is
+	 * not in the map. A missing key is inserted at the
+	 * slot that ended the search. The search is only
+	 * repeated if the table has to grow
+	 * @param k Is the key
+	 * @param v Is the value to add
+	 * @param found Output variable; true if k was
+	 * already in the map
+	 * @return The value corresponding to k
+	 */
+	T2* Place(const T1& k, const T2& v, bool& found)
+	{
+		Index j;
+		unsigned int d;
+		found = Locate(k, j, d);
+		if(found)
+			return &slots[j].val;
+		//Grow once the load factor or the probe length bound is reached
+		if((n + 1) * 100ULL > (unsigned long long) max * load || d >= MAX_DIST)
+		{
+			Rehash(max * 2);
+			Locate(k, j, d);
+		}
+		Slot cur;
+		cur.key = k;
+		cur.val = v;
+		cur.dist = (unsigned char) d;
+		if(!Shift(j, cur))
+		{	//The table grew and k moved
+			Locate(k, j);
+			return &slots[j].val;
+		}
+		++n;
+		return &slots[j].val;
+	}
+
+	/**
+	 * Puts an element at slot j, displacing elements
+	 * nearer home further along the cluster
+	 * @param j The slot; cur may not go before it
+	 * @param cur The element with its distance set
+	 * @return False if the probe length bound was reached
+	 * and the table grew; n then already counts the element
+	 */
+	bool Shift(Index j, Slot cur)
+	{
+		while(true)
+		{
+			if(slots[j].dist == 0)
+			{	//Opening found; Put element
+				slots[j] = cur;
+				return true;
+			}
+			if(slots[j].dist < cur.dist)
+			{	//Take the slot of the element nearer home
+				Slot tmp = slots[j];
+				slots[j] = cur;
+				cur = tmp;
+			}
+			if(cur.dist == MAX_DIST)
+			{	//Probe length bound reached; grow and
+				//place the element currently displaced
+				Rehash(max * 2);
+				bool found;
+				Place(cur.key, cur.val, found);
+				return false;
+			}
+			j = Next(j);
+			++cur.dist;
+		}
+	}
+
+	//The slot after j
+	Index Next(Index j) const
+	{
+		return j + 1 == max ? 0 : j + 1;
+	}
+
+	/**
+	* Resize the map's array
+	* @param The new size of the array
+	*/
+	void Rehash(unsigned int cap)
+	{
+		Slot* tmp = slots;
+		Index oldMax = max;
+		//Init also picks a new hash function
+		Init(cap);
+		for(Index i = 0; i < oldMax; ++i)
+		{
+			if(tmp[i].dist != 0)
+				Put(tmp[i].key, tmp[i].val);
+		}
+		delete [] tmp;
+	}
+
+	/**
+	* The hash function
+	* @param The element to be hashed
+	* @return The resulting hash index
+	*/
+	Index F(const T1& ele) const
+	{
+		return (Index) (hf(ele) % max);
+	}
+
+	//The hash table
+	Slot* slots;
+	//Number of elements, capacity and load factor
+	unsigned int n, max, load;
+	//The hash function
+	Hash hf;
+};
+#endif
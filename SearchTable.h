@@ -1,18 +1,47 @@
 #ifndef SEARCHTABLE_H
 #define SEARCHTABLE_H
 #include "QSort.h"
+#include "KaryNode.h"
+#include <limits>
+#include <type_traits>
 /**
  * A class that implements the Map.h interface.
  * This implements the Map ADT using a search table
  * T1 is the type of the key T2 is the type of the 
- * value in a (key, value) pair.
+ * value in a (key, value) pair. Keys and values are
+ * kept in separate sorted arrays so the binary search
+ * only touches keys. A read optimized layout can be
+ * selected with SetLayout; see Layout.
  */
 template <typename T1, typename T2>
 class SearchTable : public Map<T1, T2>
 {	//Typedef to access Map's KeyValue pair
 	//Necessary only in g++
 	typedef typename Map<T1, T2>::KeyValue KeyValue;
-public:	 
+public:
+	/**
+	 * The order of the arrays.
+	 * SORTED: Sorted order searched with a binary search.
+	 * EYTZINGER: Breadth first order of the binary search
+	 * tree, starting at index 1. The search is branchless
+	 * and prefetches the nodes a few levels down; the top
+	 * levels share cache lines.
+	 * KARY: Sorted order with a static k-ary search tree
+	 * on top (FAST). A node is one cache line of keys and
+	 * one SIMD compare picks the child; see KaryNode.h.
+	 * LEARNED: Sorted order with a piecewise linear model
+	 * of key to position. The model predicts a position
+	 * within LEARN_EPS of the key's position, which is then
+	 * searched locally. The segments take far less space
+	 * than a tree when the keys are close to evenly spaced,
+	 * like timestamps and IDs. Keys that are not numbers
+	 * give flat segments of LEARN_EPS + 1 keys.
+	 * Adding or erasing a key in a layout other than
+	 * SORTED converts to SORTED and back, O(n) like in
+	 * SORTED.
+	 */
+	enum Layout { SORTED, EYTZINGER, KARY, LEARNED };
+
 	/**
 	* Attempts to erase the (key, value) pair
 	* with key  = k. The int ELE_DNE is thrown
@@ -22,27 +51,38 @@ public:
 	void Erase(const T1& k)
 	{ 	//Attempt to find the element
 		int i;
-		if(!BinarySearch(k, i))
+		if(!Search(k, i))
 			throw this->ELE_DNE;
+		if(layout != SORTED)
+		{	//Erase in sorted order
+			Layout l = layout;
+			SetLayout(SORTED);
+			Erase(k);
+			SetLayout(l);
+			return;
+		}
 		//Overwrite element
 		for(unsigned int j = i + 1; j < n; ++j)
-			arr[j - 1] = arr[j];
+		{
+			keys[j - 1] = keys[j];
+			vals[j - 1] = vals[j];
+		}
 		--n;
 	}
 	 
 	/**
-	* Attempts to find the corresponding value
-	* for a given key. The int ELE_DNE is thrown
-	* if the key is not in the map
+	* Finds the corresponding value for a given
+	* key without throwing
 	* @param k Is the key to search for
-	* @return The value corresponding to k
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
 	*/
-	T2& Find(const T1& k) const
+	T2* TryFind(const T1& k) const
 	{	//Attempt to find the element
 		int i;
-		if(!BinarySearch(k, i))
-			throw this->ELE_DNE;
-		return arr[i].val;
+		if(!Search(k, i))
+			return NULL;
+		return &vals[i];
 	}
 
 	//Overloaded assignment operator
@@ -53,56 +93,273 @@ public:
 	}
 	
 	/**
-	* Adds a (key, value) pair to the map
+	* Adds a (key, value) pair to the map. The int
+	* DUP_ELE is thrown if the key is already in the map
 	* @param k Is the key
 	* @param v Is the value
 	*/
 	void Put(const T1& k, const T2& v)
-	{	//Check if resize is necessary
-		if(n >= max) //If so, double the capacity
-			ResizeArr(max * 2);
-		//Next, find where ele belongs in the array
-		int i;
-		if(BinarySearch(k, i))
+	{
+		bool found;
+		Place(k, v, found);
+		if(found)
 			throw this->DUP_ELE;
-		//Shift elements to the right to make room
-		for(int j = (int) n; j > i; --j)
-			arr[j] = arr[j - 1];
-		//Insert item at i
-		arr[i] = KeyValue(k, v);
-		++n;
+	}
+
+	/**
+	* Finds the corresponding value for a given key.
+	* If the key is not in the map the pair (k, T2())
+	* is added first. The key is located only once
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	T2& FindOrInsert(const T1& k)
+	{
+		bool found;
+		return *Place(k, T2(), found);
+	}
+
+	/**
+	* Sets the value for a given key, adding the
+	* (key, value) pair if the key is not in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	void Upsert(const T1& k, const T2& v)
+	{
+		bool found;
+		T2* p = Place(k, v, found);
+		if(found)
+			*p = v;
+	}
+
+	/**
+	* Adds a batch of (key, value) pairs to the map. The
+	* batch is sorted and merged into the arrays from the
+	* back in one pass, O(n + m log m) instead of O(n * m)
+	* for m Puts. The int DUP_ELE is thrown if a key is
+	* already in the map or twice in the batch; nothing
+	* is added then
+	* @param k The keys
+	* @param v The values
+	* @param m The number of pairs
+	*/
+	void PutBatch(const T1* k, const T2* v, unsigned int m)
+	{
+		if(m == 0)
+			return;
+		KeyValue* b = new KeyValue[m];
+		for(unsigned int j = 0; j < m; ++j)
+			b[j] = KeyValue(k[j], v[j]);
+		QuickSort(b, 0, m - 1);
+		Layout l = layout;
+		SetLayout(SORTED);
+		//Check every key before anything is moved
+		for(unsigned int i = 0, j = 0; j < m; ++j)
+		{
+			while(i < n && keys[i] < b[j].key)
+				++i;
+			if((j > 0 && b[j].key == b[j - 1].key) || (i < n && keys[i] == b[j].key))
+			{
+				delete [] b;
+				SetLayout(l);
+				throw this->DUP_ELE;
+			}
+		}
+		if(n + m > max)
+			ResizeArr(n + m > max * 2 ? n + m : max * 2);
+		//Merge from the back so nothing is overwritten
+		int i = (int) n - 1, j = (int) m - 1;
+		for(int w = (int) (n + m) - 1; j >= 0; --w)
+		{
+			if(i >= 0 && keys[i] > b[j].key)
+			{
+				keys[w] = keys[i];
+				vals[w] = vals[i];
+				--i;
+			}
+			else
+			{
+				keys[w] = b[j].key;
+				vals[w] = b[j].val;
+				--j;
+			}
+		}
+		n += m;
+		delete [] b;
+		SetLayout(l);
+	}
+
+	/**
+	* Erases a batch of keys. The batch is sorted and the
+	* arrays are compacted in one pass, O(n + m log m). The
+	* int ELE_DNE is thrown if a key is not in the map or
+	* twice in the batch; nothing is erased then
+	* @param k The keys
+	* @param m The number of keys
+	*/
+	void EraseBatch(const T1* k, unsigned int m)
+	{
+		if(m == 0)
+			return;
+		T1* b = new T1[m];
+		for(unsigned int j = 0; j < m; ++j)
+			b[j] = k[j];
+		QuickSort(b, 0, m - 1);
+		Layout l = layout;
+		SetLayout(SORTED);
+		//Check every key before anything is moved
+		for(unsigned int i = 0, j = 0; j < m; ++j)
+		{
+			while(i < n && keys[i] < b[j])
+				++i;
+			if((j > 0 && b[j] == b[j - 1]) || i == n || !(keys[i] == b[j]))
+			{
+				delete [] b;
+				SetLayout(l);
+				throw this->ELE_DNE;
+			}
+		}
+		//Keep the pairs not in the batch
+		unsigned int w = 0;
+		for(unsigned int i = 0, j = 0; i < n; ++i)
+		{
+			if(j < m && keys[i] == b[j])
+			{
+				++j;
+				continue;
+			}
+			keys[w] = keys[i];
+			vals[w] = vals[i];
+			++w;
+		}
+		n = w;
+		delete [] b;
+		SetLayout(l);
+	}
+
+	/**
+	* Finds the first pair with a key not less than k
+	* @param k Is the key to search for
+	* @param key Output variable of the key of the pair
+	* @return A pointer to the value of the pair or NULL
+	* if every key is less than k
+	*/
+	T2* LowerBound(const T1& k, T1& key) const
+	{
+		unsigned int i = Lower(k);
+		if(End(i))
+			return NULL;
+		key = keys[i];
+		return &vals[i];
+	}
+
+	/**
+	* Finds the first pair with a key greater than k
+	* @param k Is the key to search for
+	* @param key Output variable of the key of the pair
+	* @return A pointer to the value of the pair or NULL
+	* if no key is greater than k
+	*/
+	T2* UpperBound(const T1& k, T1& key) const
+	{
+		unsigned int i = Lower(k);
+		if(!End(i) && keys[i] == k)
+			i = Succ(i);
+		if(End(i))
+			return NULL;
+		key = keys[i];
+		return &vals[i];
+	}
+
+	/**
+	* Calls f(key, val) for every pair with lo <= key < hi
+	* in key order. Apart from the EYTZINGER layout the
+	* pairs are read contiguously from the arrays
+	* @param lo Is the smallest key of the range
+	* @param hi Is the end of the range; not included
+	* @param f Is the function to call
+	* @return The number of pairs visited
+	*/
+	template <typename F>
+	unsigned int Range(const T1& lo, const T1& hi, F f) const
+	{
+		unsigned int i = Lower(lo), c = 0;
+		if(layout != EYTZINGER)
+		{
+			for(; i < n && keys[i] < hi; ++i, ++c)
+				f(keys[i], vals[i]);
+			return c;
+		}
+		for(; i != 0 && keys[i] < hi; i = Next(i), ++c)
+			f(keys[i], vals[i]);
+		return c;
+	}
+
+	/**
+	* Calls f(key, val) for every pair in key order
+	* @param f Is the function to call
+	* @return The number of pairs visited
+	*/
+	template <typename F>
+	unsigned int ForEach(F f) const
+	{
+		if(layout != EYTZINGER)
+		{
+			for(unsigned int i = 0; i < n; ++i)
+				f(keys[i], vals[i]);
+			return n;
+		}
+		for(unsigned int i = First(), c = 0; c < n; i = Next(i), ++c)
+			f(keys[i], vals[i]);
+		return n;
 	}
 
 	//Default constructor
 	SearchTable()
 	{
 		max = DEF_CAPC;
-		arr = new KeyValue[DEF_CAPC];
+		keys = new T1[DEF_CAPC];
+		vals = new T2[DEF_CAPC];
 		n = 0;
+		layout = SORTED;
+		ClearIndex();
 	}
 
 	//Copy constructor 
 	SearchTable(const SearchTable& st)
 	{
-		arr = NULL;
+		keys = NULL;
+		vals = NULL;
+		ClearIndex();
 		Copy(st);
 	}
 
-	//Convenience constructor
-	SearchTable(const T1* keys, const T2* vals, unsigned int numEle)
+	/**
+	 * Convenience constructor
+	 * @param keys The keys
+	 * @param vals The values
+	 * @param numEle The number of pairs
+	 * @param l The layout of the arrays
+	 */
+	SearchTable(const T1* keys, const T2* vals, unsigned int numEle, Layout l = SORTED)
 	{
 		n = numEle;
 		max = (numEle * 3) / 2;
-		arr = new KeyValue[max];
-		for(unsigned int i = 0; i < numEle; ++i)
-			arr[i] = KeyValue(keys[i], vals[i]);
-		Sort();
+		this->keys = new T1[max];
+		this->vals = new T2[max];
+		layout = SORTED;
+		ClearIndex();
+		Sort(keys, vals);
+		SetLayout(l);
 	}
 
 	//Virtual destructor
 	virtual ~SearchTable()
 	{
-		delete [] arr;
+		delete [] keys;
+		delete [] vals;
+		FreeIndex();
 	}
 
    /**
@@ -113,10 +370,87 @@ public:
 	{
 		return n;
 	}
+
+	/**
+	 * Reorders the arrays into a new layout. O(n)
+	 * @param l The new layout
+	 */
+	void SetLayout(Layout l)
+	{
+		if(l == layout)
+			return;
+		if(layout == KARY || layout == LEARNED)
+		{	//The arrays are sorted; drop the index
+			FreeIndex();
+			layout = SORTED;
+			if(l == SORTED)
+				return;
+		}
+		if(l == KARY || l == LEARNED)
+		{
+			SetLayout(SORTED);
+			if(l == KARY)
+				BuildIndex();
+			else
+				BuildModel();
+			layout = l;
+			return;
+		}
+		//Eytzinger order starts at index 1
+		if(l == EYTZINGER && n + 1 > max)
+			ResizeArr(n + 1);
+		T1* tk = new T1[max];
+		T2* tv = new T2[max];
+		//Visit the tree nodes in sorted order
+		unsigned int j = First();
+		for(unsigned int i = 0; i < n; ++i, j = Next(j))
+		{
+			if(l == EYTZINGER)
+			{
+				tk[j] = keys[i];
+				tv[j] = vals[i];
+			}
+			else
+			{
+				tk[i] = keys[j];
+				tv[i] = vals[j];
+			}
+		}
+		delete [] keys;
+		delete [] vals;
+		keys = tk;
+		vals = tv;
+		layout = l;
+	}
+
+	//Returns the layout of the arrays
+	Layout GetLayout() const
+	{
+		return layout;
+	}
+
+	/**
+	 * Returns the number of bytes used by the arrays
+	 * @return: Bytes allocated for keys and values
+	 */
+	size_t Bytes() const
+	{
+		return (size_t) max * (sizeof(T1) + sizeof(T2)) + (size_t) isize * sizeof(T1) +
+			(size_t) segs * (sizeof(T1) + sizeof(unsigned int) + sizeof(double));
+	}
 	
 private:
 	//Default capacity
 	const static int DEF_CAPC = 10;;
+	//Keys per node of the k-ary tree
+	const static unsigned int KB = KaryNode<T1>::B;
+	//Largest error in positions of the learned model
+	const static unsigned int LEARN_EPS = 16;
+	//Largest height of the k-ary tree
+	const static unsigned int MAX_HEIGHT = 32;
+	//Distance in keys to the descendants prefetched by the
+	//Eytzinger search; a 64 byte line holds that many keys
+	const static unsigned int PF_STRIDE = sizeof(T1) < 64 ? 64 / sizeof(T1) : 1;
 	
 	void Copy(const SearchTable& st)
 	{
@@ -124,10 +458,357 @@ private:
 			return;
 		n = st.n;
 		max = st.max;
-		delete [] arr;
-		arr = new KeyValue[max];
-		for(unsigned int i = 0; i < max; ++i)
-			arr[i] = st.arr[i];
+		layout = st.layout;
+		delete [] keys;
+		delete [] vals;
+		FreeIndex();
+		keys = new T1[max];
+		vals = new T2[max];
+		for(unsigned int i = 0; i < (layout == EYTZINGER ? n + 1 : n); ++i)
+		{
+			keys[i] = st.keys[i];
+			vals[i] = st.vals[i];
+		}
+		if(layout == KARY)
+			BuildIndex();
+		else if(layout == LEARNED)
+			BuildModel();
+	}
+
+	/**
+	 * Searches the arrays in their current layout
+	 * @param k The key to search for
+	 * @param m Output variable of the location of the
+	 * element or of the first key greater than k. In the
+	 * EYTZINGER layout 0 means every key is less than k
+	 * @return True if the element is found false otherwise
+	 */
+	bool Search(const T1& k, int& m) const
+	{
+		if(layout == EYTZINGER)
+			return EytzingerSearch(k, m);
+		if(layout == KARY)
+			return KarySearch(k, m);
+		if(layout == LEARNED)
+			return LearnedSearch(k, m);
+		return BinarySearch(k, m);
+	}
+
+	/**
+	 * The position of the first key not less than k.
+	 * Positions follow the layout; see End and Succ
+	 */
+	unsigned int Lower(const T1& k) const
+	{
+		int m;
+		Search(k, m);
+		return (unsigned int) m;
+	}
+
+	//True if i is past the last key
+	bool End(unsigned int i) const
+	{
+		return layout == EYTZINGER ? i == 0 : i >= n;
+	}
+
+	//The position after i in key order
+	unsigned int Succ(unsigned int i) const
+	{
+		return layout == EYTZINGER ? Next(i) : i + 1;
+	}
+
+	//Sets the index pointers of a table without an index
+	void ClearIndex()
+	{
+		imem = NULL;
+		isize = 0;
+		skeys = NULL;
+		sstart = NULL;
+		slope = NULL;
+		segs = 0;
+	}
+
+	//Frees the k-ary tree and the learned model
+	void FreeIndex()
+	{
+		delete [] imem;
+		delete [] skeys;
+		delete [] sstart;
+		delete [] slope;
+		ClearIndex();
+	}
+
+	/**
+	 * The distance from key a to key b >= a used by the
+	 * learned model. Integers are subtracted exactly in 64
+	 * bits; other numbers in double. Keys that are not
+	 * numbers are all at distance 0
+	 */
+	static double Dist(const T1& a, const T1& b)
+	{
+		return Dist(a, b, std::integral_constant<int, std::numeric_limits<T1>::is_integer ? 0 :
+			(std::is_arithmetic<T1>::value ? 1 : 2)>());
+	}
+
+	static double Dist(const T1& a, const T1& b, std::integral_constant<int, 0>)
+	{
+		return (double) ((unsigned long long) b - (unsigned long long) a);
+	}
+
+	static double Dist(const T1& a, const T1& b, std::integral_constant<int, 1>)
+	{
+		return (double) b - (double) a;
+	}
+
+	static double Dist(const T1&, const T1&, std::integral_constant<int, 2>)
+	{
+		return 0;
+	}
+
+	/**
+	 * Fits the learned model to the sorted keys in one pass
+	 * (shrinking cone). A segment starts at a key and keeps
+	 * the range of slopes that put every key it covers within
+	 * LEARN_EPS of its position; a key that empties the range
+	 * starts the next segment. The slope is the middle of the
+	 * range and is never negative, so predictions are monotone
+	 */
+	void BuildModel()
+	{
+		FreeIndex();
+		if(n == 0)
+			return;
+		const double INF = std::numeric_limits<double>::infinity();
+		//The first pass counts the segments to size the arrays
+		for(int pass = 0; pass < 2; ++pass)
+		{
+			unsigned int c = 0, s = 0;
+			double lo = 0, hi = INF;
+			for(unsigned int i = 1; i <= n; ++i)
+			{
+				if(i < n)
+				{	//Slopes that keep key i within LEARN_EPS
+					double dx = Dist(keys[s], keys[i]);
+					double dy = (double) (i - s);
+					if(dx > 0)
+					{
+						double l = (dy - LEARN_EPS) / dx, h = (dy + LEARN_EPS) / dx;
+						l = l > lo ? l : lo;
+						h = h < hi ? h : hi;
+						if(l <= h)
+						{
+							lo = l;
+							hi = h;
+							continue;
+						}
+					}
+					else if(dy <= LEARN_EPS)
+						continue;
+				}
+				//Keys s to i - 1 form a segment
+				if(pass == 1)
+				{
+					skeys[c] = keys[s];
+					sstart[c] = s;
+					slope[c] = hi == INF ? lo : (lo + hi) / 2;
+				}
+				++c;
+				s = i;
+				lo = 0;
+				hi = INF;
+			}
+			if(pass == 0)
+			{
+				segs = c;
+				skeys = new T1[segs];
+				sstart = new unsigned int[segs + 1];
+				slope = new double[segs];
+				sstart[segs] = n;
+			}
+		}
+	}
+
+	/**
+	 * Searches with the learned model. A binary search over
+	 * the first keys of the segments picks the segment, which
+	 * predicts the position. Only the keys within LEARN_EPS
+	 * of the prediction are searched
+	 * @param k The key to search for
+	 * @param m Output variable of the location of the element
+	 * (if it exists) or the location it should be (if it does not)
+	 * @return True if the element is found false otherwise
+	 */
+	bool LearnedSearch(const T1& k, int& m) const
+	{
+		if(n == 0 || k < keys[0])
+		{
+			m = 0;
+			return false;
+		}
+		if(keys[n - 1] < k)
+		{
+			m = (int) n;
+			return false;
+		}
+		//Last segment starting at or before k
+		unsigned int s = 0, e = segs;
+		while(e - s > 1)
+		{
+			unsigned int c = s + (e - s) / 2;
+			if(k < skeys[c])
+				e = c;
+			else
+				s = c;
+		}
+		//A key in the gap after a segment may be predicted far
+		//past it; its position is the start of the next one
+		double p = sstart[s] + slope[s] * Dist(skeys[s], k);
+		p = p < sstart[s + 1] ? p : sstart[s + 1];
+		p = p > sstart[s] ? p : sstart[s];
+		//One more position on each side for rounding
+		double l = p - LEARN_EPS - 1, h = p + LEARN_EPS + 2;
+		unsigned int lo = l > sstart[s] ? (unsigned int) l : sstart[s];
+		unsigned int hi = h < sstart[s + 1] ? (unsigned int) h : sstart[s + 1];
+		//First key in [lo, hi) not less than k
+		while(lo < hi)
+		{
+			unsigned int c = lo + (hi - lo) / 2;
+			if(keys[c] < k)
+				lo = c + 1;
+			else
+				hi = c;
+		}
+		m = (int) lo;
+		return lo < n && keys[lo] == k;
+	}
+
+	/**
+	 * Builds the k-ary tree over the sorted keys. The keys
+	 * form leaf blocks of KB keys; a node at height l has
+	 * KB + 1 children and holds the largest key below each
+	 * of its first KB children. The last leaf block and the
+	 * nodes are padded with the largest key
+	 */
+	void BuildIndex()
+	{
+		FreeIndex();
+		height = 0;
+		leaves = (n + KB - 1) / KB;
+		if(n == 0)
+			return;
+		if(max < leaves * KB)
+			ResizeArr(leaves * KB);
+		for(unsigned int i = n; i < leaves * KB; ++i)
+			keys[i] = keys[n - 1];
+		//Leaf blocks below a node at each height
+		unsigned long long span[MAX_HEIGHT + 1];
+		span[0] = 1;
+		while(span[height] < leaves)
+		{
+			span[height + 1] = span[height] * (KB + 1);
+			++height;
+			offs[height] = isize;
+			isize += (unsigned int) ((leaves + span[height] - 1) / span[height]) * KB;
+		}
+		if(height == 0)
+			return;
+		//Align the nodes to cache lines
+		imem = new T1[isize + KB];
+		size_t a = (size_t) imem % 64;
+		index = imem + (a == 0 || 64 % sizeof(T1) != 0 ? 0 : (64 - a) / sizeof(T1));
+		for(unsigned int l = 1; l <= height; ++l)
+		{
+			T1* node = index + offs[l];
+			unsigned long long nodes = (leaves + span[l] - 1) / span[l];
+			for(unsigned long long x = 0; x < nodes; ++x)
+			{
+				for(unsigned int c = 0; c < KB; ++c)
+				{	//Last key under child c
+					unsigned long long e = (x * (KB + 1) + c + 1) * span[l - 1] * KB;
+					node[x * KB + c] = keys[(e < n ? e : n) - 1];
+				}
+			}
+		}
+	}
+
+	/**
+	 * Searches the k-ary tree. Each level counts the keys
+	 * of one node less than k, which gives the child; the
+	 * leaf block gives the position in the sorted arrays
+	 * @param k The key to search for
+	 * @param m Output variable of the location of the element
+	 * (if it exists) or the location it should be (if it does not)
+	 * @return True if the element is found false otherwise
+	 */
+	bool KarySearch(const T1& k, int& m) const
+	{	//Larger keys would rank past the padding
+		if(n == 0 || keys[n - 1] < k)
+		{
+			m = (int) n;
+			return false;
+		}
+		unsigned int x = 0;
+		for(unsigned int l = height; l > 0; --l)
+			x = x * (KB + 1) + KaryNode<T1>::Rank(index + offs[l] + x * KB, k);
+		m = (int) (x * KB + KaryNode<T1>::Rank(keys + x * KB, k));
+		return keys[m] == k;
+	}
+
+	/**
+	 * Searches the Eytzinger layout. Every step goes to
+	 * child 2j or 2j + 1 without a branch. The path ends
+	 * past a leaf; the last node where it went left holds
+	 * the smallest key not less than k
+	 * @param k The key to search for
+	 * @param m Output variable of the location of the element
+	 * @return True if the element is found false otherwise
+	 */
+	bool EytzingerSearch(const T1& k, int& m) const
+	{
+		unsigned int j = 1;
+		while(j <= n)
+		{
+#ifdef __GNUC__
+			//The descendants log2(PF_STRIDE) levels down share a line
+			__builtin_prefetch(keys + j * PF_STRIDE);
+#endif
+			j = 2 * j + (keys[j] < k);
+		}
+		//Undo the right turns and the last left turn
+#ifdef __GNUC__
+		j >>= __builtin_ctz(~j) + 1;
+#else
+		while(j & 1)
+			j >>= 1;
+		j >>= 1;
+#endif
+		m = (int) j;
+		return j != 0 && keys[j] == k;
+	}
+
+	//The first tree node in sorted order; the leftmost
+	unsigned int First() const
+	{
+		unsigned int j = 1;
+		while(2 * j <= n)
+			j *= 2;
+		return j;
+	}
+
+	//The tree node after node j in sorted order
+	unsigned int Next(unsigned int j) const
+	{
+		if(2 * j + 1 <= n)
+		{	//Leftmost node of the right subtree
+			j = 2 * j + 1;
+			while(2 * j <= n)
+				j *= 2;
+			return j;
+		}
+		//Up to the first ancestor reached from the left
+		while(j & 1)
+			j >>= 1;
+		return j >> 1;
 	}
 
 	/**
@@ -147,9 +828,9 @@ private:
 			if(s > e)
 				break;
 			//Test the value at the point
-			if(arr[m].key == k)	//found it
+			if(keys[m] == k)	//found it
 				return true;
-			else if(arr[m].key > k)
+			else if(keys[m] > k)
 				e = m - 1;
 			else
 				s = m + 1;
@@ -157,6 +838,47 @@ private:
 		return false;
 	}
 	
+	/**
+	 * Finds the value of key k, adding (k, v) at the
+	 * position found by the binary search if k is not
+	 * in the map
+	 * @param k Is the key
+	 * @param v Is the value to add
+	 * @param found Output variable; true if k was
+	 * already in the map
+	 * @return The value corresponding to k
+	 */
+	T2* Place(const T1& k, const T2& v, bool& found)
+	{	//Find where ele belongs in the array
+		int i;
+		found = Search(k, i);
+		if(found)
+			return &vals[i];
+		if(layout != SORTED)
+		{	//Insert in sorted order
+			Layout l = layout;
+			SetLayout(SORTED);
+			Place(k, v, found);
+			SetLayout(l);
+			Search(k, i);
+			return &vals[i];
+		}
+		//Check if resize is necessary
+		if(n >= max) //If so, double the capacity
+			ResizeArr(max * 2);
+		//Shift elements to the right to make room
+		for(int j = (int) n; j > i; --j)
+		{
+			keys[j] = keys[j - 1];
+			vals[j] = vals[j - 1];
+		}
+		//Insert item at i
+		keys[i] = k;
+		vals[i] = v;
+		++n;
+		return &vals[i];
+	}
+
 	/**
 	 * Resize the list's array
 	 * @param The new size of the array
@@ -164,25 +886,77 @@ private:
 	void ResizeArr(unsigned int cap)
 	{
 		max = cap;
-		KeyValue* tmp = new KeyValue[cap];
+		T1* tk = new T1[cap];
+		T2* tv = new T2[cap];
 		for(unsigned int i = 0; i < n; ++i)
-			tmp[i] = arr[i];
-		delete [] arr;
-		arr = tmp;
+		{
+			tk[i] = keys[i];
+			tv[i] = vals[i];
+		}
+		delete [] keys;
+		delete [] vals;
+		keys = tk;
+		vals = tv;
 	}
 
 
-	//Sorts the underlying array
-	void Sort()
-	{
-		QuickSort(arr, 0, n - 1);
+	/**
+	 * Fills the arrays with the n given pairs in
+	 * sorted order. The pairs are sorted together as
+	 * KeyValues and then split, unless the keys are
+	 * already in increasing order
+	 * @param k The keys
+	 * @param v The values
+	 */
+	void Sort(const T1* k, const T2* v)
+	{	//Input that is already sorted is copied as is
+		unsigned int s = 1;
+		while(s < n && k[s - 1] < k[s])
+			++s;
+		if(s >= n)
+		{
+			for(unsigned int i = 0; i < n; ++i)
+			{
+				keys[i] = k[i];
+				vals[i] = v[i];
+			}
+			return;
+		}
+		KeyValue* tmp = new KeyValue[max];
+		for(unsigned int i = 0; i < n; ++i)
+			tmp[i] = KeyValue(k[i], v[i]);
+		QuickSort(tmp, 0, n - 1);
+		for(unsigned int i = 0; i < n; ++i)
+		{
+			keys[i] = tmp[i].key;
+			vals[i] = tmp[i].val;
+		}
+		delete [] tmp;
 	}
 
 	//Number of elements in the SearchTable
 	unsigned int n;
-	//Capacity of arr
+	//Capacity of the arrays
 	unsigned int max;
-	//The underlying array
-	KeyValue* arr;
+	//The keys and their values in the order of layout
+	T1* keys;
+	T2* vals;
+	//The order of the arrays
+	Layout layout;
+	//The k-ary tree: its allocation, the aligned nodes in
+	//it and the offset of each height in index
+	T1* imem;
+	T1* index;
+	unsigned int offs[MAX_HEIGHT + 1];
+	//Number of keys in the tree, its height and the
+	//number of leaf blocks
+	unsigned int isize, height, leaves;
+	//The learned model: the first key, first position and
+	//slope of each segment and the number of segments.
+	//sstart[segs] is n
+	T1* skeys;
+	unsigned int* sstart;
+	double* slope;
+	unsigned int segs;
 };
 #endif
@@ -1,7 +1,13 @@
 #ifndef LINKEDLIST_H
 #define LINKEDLIST_H
+#include <type_traits>
 #include "List.h"
-template <typename T>
+#include "SlabAllocator.h"
+/**
+ * A singly linked list. Nodes come from an allocator
+ * of type Alloc; see SlabAllocator.h
+ */
+template <typename T, template <typename> class Alloc = SlabAllocator>
 class LinkedList : public List<T>
 {
 public:
@@ -11,7 +17,7 @@ public:
 	 */
 	virtual void Add(const T& ele)
 	{	//Create the new list node
-		LNode* newNode = new LNode(ele, headPtr);
+		LNode* newNode = alloc.New(ele, headPtr);
 		//Set the node as the new head node
 		headPtr = newNode;
 		++n;
@@ -19,12 +25,23 @@ public:
 	}
 	
 	/**
-	 * Clears the list
+	 * Clears the list. Nodes without destructors are not
+	 * visited if the allocator can release them all at once
 	 */
 	virtual void Clear()
 	{
-		while(headPtr != NULL)
-			Remove(0);
+		if(!Alloc<LNode>::BULK || !std::is_trivially_destructible<LNode>::value)
+		{
+			while(headPtr != NULL)
+			{
+				LNode* oldNode = headPtr;
+				headPtr = headPtr->next;
+				alloc.Delete(oldNode);
+			}
+		}
+		alloc.Clear();
+		headPtr = NULL;
+		n = 0;
 	}
 	
 	/**
@@ -112,7 +129,7 @@ public:
 	    if(i == n - 1)
 	    {
 	        headPtr = headPtr->next;
-	        delete lstPtr;
+	        alloc.Delete(lstPtr);
 	    }
 	    else
 	    {
@@ -123,7 +140,7 @@ public:
 			//If the next node is NULL; set the next to NULL
 			//lstPtr->next = (oldNode == NULL ? NULL : oldNode->next);
 			lstPtr->next = oldNode->next;
-			delete oldNode;
+			alloc.Delete(oldNode);
 	    }
         --n;
 	}
@@ -152,6 +169,12 @@ public:
 	{
 		return n;
 	}
+
+	//Returns the number of calls to the system allocator
+	size_t SystemAllocs() const
+	{
+		return alloc.SystemAllocs();
+	}
 	
 private:
 
@@ -180,5 +203,7 @@ private:
 
 	LNode* headPtr;
 	unsigned int n;
+	//Allocates the nodes
+	Alloc<LNode> alloc;
 };
 #endif
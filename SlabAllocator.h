@@ -0,0 +1,183 @@
+#ifndef SLABALLOCATOR_H
+#define SLABALLOCATOR_H
+#include <cstddef>
+#include <cstdint>
+#include <new>
+/**
+ * Node allocators for the node based containers (AVLTree,
+ * BinarySearchTree and the linked lists). A container takes the
+ * allocator as a template template parameter and keeps one
+ * allocator of its node type. New constructs a node and Delete
+ * destroys one; Clear frees all memory at once and may only be
+ * called once every node has been destroyed, or if BULK is true,
+ * when the nodes have trivial destructors. BULK tells if Clear
+ * releases the nodes, so a container can skip visiting them.
+ */
+
+/**
+ * Carves nodes out of slabs. The first slab holds FIRST_SLAB
+ * nodes and each new slab twice as many, up to MAX_SLAB. Deleted
+ * nodes go on a free list and are reused before slab memory, so
+ * the nodes of a container stay close together and a node costs
+ * no call to the system allocator. Clear frees the slabs without
+ * visiting the nodes. Nodes are aligned to alignof(T) even past
+ * what operator new guarantees, so a node type may be aligned to
+ * a cache line.
+ */
+template <typename T>
+class SlabAllocator
+{
+public:
+	//Clear releases all nodes
+	const static bool BULK = true;
+
+	SlabAllocator()
+	{
+		slabs = NULL;
+		Reset();
+		sys = 0;
+	}
+
+	//Frees all slabs
+	~SlabAllocator()
+	{
+		Clear();
+	}
+
+	/**
+	 * Constructs a node
+	 * @param a The arguments of the constructor of T
+	 * @return The node
+	 */
+	template <typename... A>
+	T* New(const A&... a)
+	{
+		return new (Allocate()) T(a...);
+	}
+
+	/**
+	 * Destroys a node and puts its memory on the free list
+	 * @param p The node
+	 */
+	void Delete(T* p)
+	{
+		p->~T();
+		*(void**) p = free;
+		free = p;
+	}
+
+	//Frees all slabs; see the comment at the top
+	void Clear()
+	{
+		while(slabs != NULL)
+		{
+			char* s = slabs;
+			slabs = ((char**) s)[0];
+			::operator delete(((char**) s)[1]);
+		}
+		Reset();
+	}
+
+	//Returns the number of calls to the system allocator
+	size_t SystemAllocs() const
+	{
+		return sys;
+	}
+
+private:
+	//Number of nodes in the first and the largest slabs
+	const static size_t FIRST_SLAB = 16;
+	const static size_t MAX_SLAB = 4096;
+	//Alignment and size of a node slot; a free slot holds
+	//the next free slot
+	const static size_t ALIGN = alignof(T) > sizeof(void*) ? alignof(T) : sizeof(void*);
+	const static size_t SLOT = (sizeof(T) + ALIGN - 1) / ALIGN * ALIGN;
+	//Bytes at the start of a slab holding the next slab and
+	//the memory returned by operator new
+	const static size_t HEAD = ALIGN < 2 * sizeof(void*) ? 2 * sizeof(void*) : ALIGN;
+
+	//Slabs are owned; not copyable
+	SlabAllocator(const SlabAllocator&);
+	SlabAllocator& operator=(const SlabAllocator&);
+
+	//Forgets the free list and the current slab
+	void Reset()
+	{
+		free = NULL;
+		next = end = NULL;
+		cap = FIRST_SLAB;
+	}
+
+	//Returns memory for a node
+	void* Allocate()
+	{
+		if(free != NULL)
+		{
+			void* p = free;
+			free = *(void**) p;
+			return p;
+		}
+		if(next == end)
+		{	//New slab at the front of the slab list
+			char* m = (char*) ::operator new(ALIGN - 1 + HEAD + cap * SLOT);
+			char* s = m + (ALIGN - (uintptr_t) m % ALIGN) % ALIGN;
+			((char**) s)[0] = slabs;
+			((char**) s)[1] = m;
+			slabs = s;
+			next = s + HEAD;
+			end = next + cap * SLOT;
+			++sys;
+			if(cap < MAX_SLAB)
+				cap *= 2;
+		}
+		void* p = next;
+		next += SLOT;
+		return p;
+	}
+
+	//The list of slabs and the free list
+	char* slabs;
+	void* free;
+	//The unused part of the newest slab
+	char* next;
+	char* end;
+	//Number of nodes in the next slab
+	size_t cap;
+	//Number of slabs allocated
+	size_t sys;
+};
+
+/**
+ * Allocates every node with new and delete. Clear does
+ * nothing, so a container has to delete every node
+ */
+template <typename T>
+class HeapAllocator
+{
+public:
+	//Clear does not release nodes
+	const static bool BULK = false;
+
+	HeapAllocator() { sys = 0; }
+
+	template <typename... A>
+	T* New(const A&... a)
+	{
+		++sys;
+		return new T(a...);
+	}
+
+	void Delete(T* p) { delete p; }
+
+	void Clear() { }
+
+	//Returns the number of calls to the system allocator
+	size_t SystemAllocs() const { return sys; }
+
+private:
+	HeapAllocator(const HeapAllocator&);
+	HeapAllocator& operator=(const HeapAllocator&);
+
+	size_t sys;
+};
+#endif
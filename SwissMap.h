@@ -0,0 +1,408 @@
+#ifndef SWISSMAP_H
+#define SWISSMAP_H
+#include "Hash.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+typedef unsigned int Index;
+
+/**
+ * A map implementation that uses an open addressing hash
+ * table in the style of a Swiss table. A separate array of
+ * one byte control tags holds either EMPTY, DELETED or the
+ * low 7 bits of the key's hash. Tags are probed in groups
+ * of 16 using a single SSE2 compare so keys and values are
+ * only read when a tag matches. Hash is the hash functor
+ * type; see Hash.h.
+ */
+template <typename T1, typename T2, typename Hash = DefaultHash<T1> >
+class SwissMap : public Map<T1, T2>
+{
+public:
+	/**
+	* Attempts to erase the (key, value) pair
+	* with key  = k. The int ELE_DNE is thrown
+	* if the key is not in the map
+	* @param k Is the key of the pair to erase
+	*/
+	virtual void Erase(const T1& k)
+	{
+		Index i;
+		if(!Locate(k, i))
+			throw this->ELE_DNE;
+		//A group with an empty slot has never been full so no
+		//probe sequence continues past it; no tombstone needed
+		if(Match(i / GROUP, EMPTY) != 0)
+			ctrl[i] = EMPTY;
+		else
+		{
+			ctrl[i] = DELETED;
+			++del;
+		}
+		--n;
+	}
+
+	/**
+	* Finds the corresponding value for a given
+	* key without throwing
+	* @param k Is the key to search for
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
+	*/
+	virtual T2* TryFind(const T1& k) const
+	{
+		Index i;
+		if(!Locate(k, i))
+			return NULL;
+		return &slots[i].val;
+	}
+
+	/**
+	* Create a map with a default initial
+	* capacity
+	*/
+	SwissMap()
+	{
+		Init(GROUP);
+	}
+
+	/**
+	* Create a map with a initial capacity
+	* @param capc The initial capacity
+	*/
+	SwissMap(unsigned int capc)
+	{
+		Init(capc);
+	}
+
+	//Copy constructor
+	SwissMap(const SwissMap& sm)
+	{
+		ctrl = NULL;
+		slots = NULL;
+		Copy(sm);
+	}
+
+	//Destructor
+	virtual ~SwissMap()
+	{
+		delete [] ctrl;
+		delete [] slots;
+	}
+
+	//Overloaded assignment operator
+	SwissMap& operator=(const SwissMap& sm)
+	{
+		Copy(sm);
+		return *this;
+	}
+
+	/**
+	* Adds a (key, value) pair to the map. The int
+	* DUP_ELE is thrown if the key is already in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Put(const T1& k, const T2& v)
+	{
+		bool found;
+		Place(k, v, found);
+		if(found)
+			throw this->DUP_ELE;
+	}
+
+	/**
+	* Finds the corresponding value for a given key.
+	* If the key is not in the map the pair (k, T2())
+	* is added first. The key is located only once
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	virtual T2& FindOrInsert(const T1& k)
+	{
+		bool found;
+		return *Place(k, T2(), found);
+	}
+
+	/**
+	* Sets the value for a given key, adding the
+	* (key, value) pair if the key is not in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	virtual void Upsert(const T1& k, const T2& v)
+	{
+		bool found;
+		T2* p = Place(k, v, found);
+		if(found)
+			*p = v;
+	}
+
+	/**
+	 * Returns the number of elements in the Map
+	 * @return: Number of elements in map object
+	 */
+	virtual unsigned int Size() const
+	{
+		return n;
+	}
+
+private:
+	/**
+	 * A (key, value) slot. Unlike Map's KeyValue it needs
+	 * no open flag since occupancy lives in the tags
+	 */
+	class Slot
+	{
+	public:
+		T1 key;
+		T2 val;
+	};
+
+	//Number of control tags compared at once
+	const static Index GROUP = 16;
+	//Control tag values; full slots hold 0 to 127
+	const static signed char EMPTY = -128;
+	const static signed char DELETED = -2;
+
+	/**
+	 * Allocates an empty table
+	 * @param capc The minimum number of slots
+	 */
+	void Init(unsigned int capc)
+	{	//Number of groups must be a power of 2
+		numGroups = 1;
+		while(numGroups * GROUP < capc)
+			numGroups *= 2;
+		max = numGroups * GROUP;
+		n = del = 0;
+		ctrl = new signed char[max];
+		for(Index i = 0; i < max; ++i)
+			ctrl[i] = EMPTY;
+		slots = new Slot[max];
+		//Pick a new hash function
+		hf = Hash();
+	}
+
+	/**
+	 * Copies a SwissMap
+	 */
+	void Copy(const SwissMap& sm)
+	{
+		if(this == &sm)
+			return;
+		delete [] ctrl;
+		delete [] slots;
+		hf = sm.hf;
+		max = sm.max;
+		numGroups = sm.numGroups;
+		n = sm.n;
+		del = sm.del;
+		ctrl = new signed char[max];
+		slots = new Slot[max];
+		for(Index i = 0; i < max; ++i)
+		{
+			ctrl[i] = sm.ctrl[i];
+			slots[i] = sm.slots[i];
+		}
+	}
+
+	/**
+	 * Finds the slot holding key k
+	 * @param k The key to search for
+	 * @param i Output variable of the slot of k
+	 * @return True if the key is found false otherwise
+	 */
+	bool Locate(const T1& k, Index& i) const
+	{
+		unsigned long long h = F(k);
+		signed char t = (signed char) (h & 0x7F);
+		Index g = (Index) (h >> 7) & (numGroups - 1);
+		for(Index p = 0; p < numGroups; ++p)
+		{	//Only compare keys whose tag matches
+			for(unsigned int m = Match(g, t); m != 0; m &= m - 1)
+			{
+				i = g * GROUP + LowBit(m);
+				if(slots[i].key == k)
+					return true;
+			}
+			//An empty slot ends the probe sequence
+			if(Match(g, EMPTY) != 0)
+				return false;
+			//Triangular probing visits every group
+			g = (g + p + 1) & (numGroups - 1);
+		}
+		return false;
+	}
+
+	/**
+	 * Finds the slot holding key k. If k is not in the
+	 * table i is the first empty or deleted slot on the
+	 * probe sequence of k, where k would be inserted
+	 * @param k The key to search for
+	 * @param h The hash of k
+	 * @param i Output variable of the slot of k
+	 * @return True if the key is found false otherwise
+	 */
+	bool Probe(const T1& k, unsigned long long h, Index& i) const
+	{
+		signed char t = (signed char) (h & 0x7F);
+		Index g = (Index) (h >> 7) & (numGroups - 1);
+		bool free = false;
+		for(Index p = 0; p < numGroups; ++p)
+		{
+			for(unsigned int m = Match(g, t); m != 0; m &= m - 1)
+			{
+				Index j = g * GROUP + LowBit(m);
+				if(slots[j].key == k)
+				{
+					i = j;
+					return true;
+				}
+			}
+			//Remember the first free slot
+			unsigned int m = free ? 0 : MatchFree(g);
+			if(m != 0)
+			{
+				i = g * GROUP + LowBit(m);
+				free = true;
+			}
+			if(Match(g, EMPTY) != 0)
+				return false;
+			g = (g + p + 1) & (numGroups - 1);
+		}
+		return false;
+	}
+
+	/**
+	 * Finds the value of key k, adding (k, v) if k is
+	 * not in the map. The search is only repeated if the
+	 * table has to be rehashed first
+	 * @param k Is the key
+	 * @param v Is the value to add
+	 * @param found Output variable; true if k was
+	 * already in the map
+	 * @return The value corresponding to k
+	 */
+	T2* Place(const T1& k, const T2& v, bool& found)
+	{
+		unsigned long long h = F(k);
+		//Probe always sets i as the load limit leaves a free slot
+		Index i = 0;
+		found = Probe(k, h, i);
+		if(found)
+			return &slots[i].val;
+		//Keep at most 7/8 of the slots in use; if most of
+		//those are tombstones rehash at the same size
+		if((n + del + 1) * 8 > max * 7)
+		{	//Rehash picks a new hash function
+			Rehash(n * 16 >= max * 7 ? max * 2 : max);
+			h = F(k);
+			//k is still missing; only the new free slot is needed
+			found = Probe(k, h, i);
+		}
+		if(ctrl[i] == DELETED)
+			--del;
+		ctrl[i] = (signed char) (h & 0x7F);
+		slots[i].key = k;
+		slots[i].val = v;
+		++n;
+		return &slots[i].val;
+	}
+
+	/**
+	 * Compares all tags of a group with t
+	 * @param g The group index
+	 * @param t The tag to compare with
+	 * @return A mask with bit i set if tag i equals t
+	 */
+	unsigned int Match(Index g, signed char t) const
+	{
+#ifdef __SSE2__
+		__m128i c = _mm_loadu_si128((const __m128i*) (ctrl + g * GROUP));
+		return (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8(t)));
+#else
+		unsigned int m = 0;
+		for(Index i = 0; i < GROUP; ++i)
+			if(ctrl[g * GROUP + i] == t)
+				m |= 1u << i;
+		return m;
+#endif
+	}
+
+	/**
+	 * Finds the empty or deleted slots of a group.
+	 * Both have the sign bit set while full tags do not
+	 * @param g The group index
+	 * @return A mask with bit i set if slot i is free
+	 */
+	unsigned int MatchFree(Index g) const
+	{
+#ifdef __SSE2__
+		__m128i c = _mm_loadu_si128((const __m128i*) (ctrl + g * GROUP));
+		return (unsigned int) _mm_movemask_epi8(c);
+#else
+		unsigned int m = 0;
+		for(Index i = 0; i < GROUP; ++i)
+			if(ctrl[g * GROUP + i] < 0)
+				m |= 1u << i;
+		return m;
+#endif
+	}
+
+	//Returns the index of the lowest set bit of m != 0
+	static Index LowBit(unsigned int m)
+	{
+#ifdef __GNUC__
+		return (Index) __builtin_ctz(m);
+#else
+		Index i = 0;
+		while(!(m & 1))
+		{
+			m >>= 1;
+			++i;
+		}
+		return i;
+#endif
+	}
+
+	/**
+	* Resize the map's arrays
+	* @param The new number of slots
+	*/
+	void Rehash(unsigned int cap)
+	{
+		signed char* oc = ctrl;
+		Slot* os = slots;
+		Index oldMax = max;
+		//Init also picks a new hash function
+		Init(cap);
+		for(Index i = 0; i < oldMax; ++i)
+		{
+			if(oc[i] >= 0)
+				Put(os[i].key, os[i].val);
+		}
+		delete [] oc;
+		delete [] os;
+	}
+
+	/**
+	* The hash function. The tag and the group index
+	* are taken from different bits of the result
+	* @param The element to be hashed
+	* @return The resulting 64-bit hash
+	*/
+	unsigned long long F(const T1& ele) const
+	{
+		return hf(ele);
+	}
+
+	//Control tags and (key, value) slots
+	signed char* ctrl;
+	Slot* slots;
+	//Number of elements, tombstones, slots and groups
+	unsigned int n, del, max, numGroups;
+	//The hash function
+	Hash hf;
+};
+#endif
@@ -6,9 +6,10 @@
  * This implements the Map ADT using a binary
  * search tree. T1 is the 
  * type of the key T2 is the type of the 
- * value in a (key, value) pair.
+ * value in a (key, value) pair. Alloc is the
+ * allocator of the tree nodes; see SlabAllocator.h
  */
-template <typename T1, typename T2>
+template <typename T1, typename T2, template <typename> class Alloc = SlabAllocator>
 class TreeMap : public Map<T1, T2>
 {	//Typedef to access Map's KeyValue pair
 	//Necessary only in g++
@@ -35,24 +36,16 @@ public:
 	}
 
 	/**
-	* Attempts to find the corresponding value
-	* for a given key. The int ELE_DNE is thrown
-	* if the key is not in the map
+	* Finds the corresponding value for a given
+	* key without throwing
 	* @param k Is the key to search for
-	* @return The value corresponding to k
+	* @return A pointer to the value corresponding
+	* to k or NULL if k is not in the map
 	*/
-	T2& Find(const T1& k) const
-	{	//Attempt to find the element
-		try
-		{
-			return bst.Find(KeyValue(k)).val;
-		}
-		catch(int error)
-		{	//Check the exception error code
-			if(error == bst.ELE_DNE)
-				throw this->ELE_DNE;
-		}
-		throw this->ELE_DNE;
+	T2* TryFind(const T1& k) const
+	{
+		KeyValue* kv = bst.TryFind(KeyValue(k));
+		return kv == NULL ? NULL : &kv->val;
 	}
 
 	//Overloaded assignment operator
@@ -63,13 +56,44 @@ public:
 	}
 
 	/**
-	* Adds a (key, value) pair to the map
+	* Adds a (key, value) pair to the map. The int
+	* DUP_ELE is thrown if the key is already in the map
 	* @param k Is the key
 	* @param v Is the value
 	*/
 	void Put(const T1& k, const T2& v)
 	{	//Add the element to the BST
-		bst.Insert(KeyValue(k, v));
+		bool found;
+		bst.FindOrInsert(KeyValue(k, v), found);
+		if(found)
+			throw this->DUP_ELE;
+	}
+
+	/**
+	* Finds the corresponding value for a given key.
+	* If the key is not in the map the pair (k, T2())
+	* is added first. The tree is descended once
+	* @param k Is the key
+	* @return The value corresponding to k
+	*/
+	T2& FindOrInsert(const T1& k)
+	{
+		bool found;
+		return bst.FindOrInsert(KeyValue(k, T2()), found).val;
+	}
+
+	/**
+	* Sets the value for a given key, adding the
+	* (key, value) pair if the key is not in the map
+	* @param k Is the key
+	* @param v Is the value
+	*/
+	void Upsert(const T1& k, const T2& v)
+	{
+		bool found;
+		KeyValue& kv = bst.FindOrInsert(KeyValue(k, v), found);
+		if(found)
+			kv.val = v;
 	}
 
 	/**
@@ -80,6 +104,12 @@ public:
 	{	//Return the size of the underlying list
 		return bst.Size();
 	}
+
+	//Returns the number of calls to the system allocator
+	size_t SystemAllocs() const
+	{
+		return bst.SystemAllocs();
+	}
 	
 	//Already handled by BST class
 	TreeMap() { }
@@ -92,6 +122,6 @@ public:
 	  
 private:
 	//BST
-	BinarySearchTree<KeyValue> bst;
+	BinarySearchTree<KeyValue, Alloc> bst;
 };
 #endif
@@ -1,10 +1,24 @@
 #include <iostream>
 #include <fstream>
 #include <ctime>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include "Map.h"
 #include "HashMap.h"
+#include "SwissMap.h"
+#include "RobinHoodMap.h"
+#include "CuckooMap.h"
+#include "ConcurrentHashMap.h"
+#include "EpochHashMap.h"
 #include "SearchTable.h"
 #include "TreeMap.h"
+#include "AVLMap.h"
+#include "BPlusTreeMap.h"
+#include "BloomMap.h"
+#include "PerfectHashMap.h"
+#include "LSMMap.h"
+#include "MappedTable.h"
 #include "ArrayList.h"
 #define NUM_TST 10000
 using namespace std;
@@ -13,6 +27,51 @@ const static int ERROR = -1357;
 
 const static int MAP_SIZE = 10000;
 const static int SPACING = 1000;
+//Largest number of extra entries used by the erase benchmark
+const static long ERASE_FILL = 1000000;
+//Largest number of entries used by the find benchmark
+const static long FIND_FILL = 10000000;
+//Number of times each key is hashed by the hash benchmark
+const static int HASH_REPS = 1000;
+//Number of probe lengths reported by the hash benchmark
+const static unsigned int PROBE_LEN = 16;
+//Map sizes used by the capacity policy benchmark
+const static long CAPC_SIZES[] = {1000, 1000000, 100000000};
+//Batch sizes and number of lookups used by the batched find benchmark
+const static size_t BATCH_SIZES[] = {64, 256};
+const static long BATCH_KEYS = 1000000;
+//Number of Puts and histogram buckets used by the latency benchmark
+const static long LAT_PUTS = 10000000;
+const static unsigned int LAT_BUCKETS = 32;
+//Number of lookups per miss ratio in the miss benchmark
+const static long MISS_KEYS = 1000000;
+//Number of counter updates in the aggregation benchmark
+const static long AGG_KEYS = 1000000;
+//Number of lookups per miss ratio in the Bloom filter benchmark
+//and the largest number of entries it uses
+const static long BLOOM_FILL = 1000000;
+//Table sizes used by the layout benchmark; the keys fit in
+//about L1, L2, the last level cache and DRAM
+const static long LAYOUT_SIZES[] = {4000, 64000, 1000000, 16000000};
+//Number of lookups per table in the layout benchmark
+const static long LAYOUT_KEYS = 1000000;
+//Table sizes used by the batch load benchmark
+const static long LOAD_SIZES[] = {10000, 100000};
+//Range widths and number of scans per width in the scan benchmark
+const static long SCAN_WIDTHS[] = {10, 100, 1000, 10000};
+const static long SCAN_KEYS = 10000000;
+//Map sizes used by the perfect hash benchmark
+const static long PERFECT_SIZES[] = {10000, 1000000, 10000000};
+//Number of operations per write ratio in the mixed benchmark
+//and the number of distinct keys it uses
+const static long MIX_OPS = 100000;
+const static long MIX_KEYS = 100000;
+//Largest map size used by the growth benchmark
+const static long GROWTH_MAX = 4194304;
+//Map sizes used by the node allocator benchmark
+const static long ALLOC_SIZES[] = {10000, 100000, 1000000, 4000000};
+//Number of operations per thread in the scaling benchmark
+const static long SCALE_OPS = 1000000;
 
 //Array of random values to test with
 static long VALS[MAP_SIZE];
@@ -23,6 +82,167 @@ static long VALS[MAP_SIZE];
 template <typename T1, typename T2>
 void CreateCSV(const string& fn, Map<T1, T2>& map);
 
+//Used to time erase against the number of entries
+//already in the map
+//fn: The filename
+//map: The map to time
+template <typename T1, typename T2>
+void CreateEraseCSV(const string& fn, Map<T1, T2>& map);
+
+//Used to time find against the number of entries
+//in the map
+//fn: The filename
+//map: The map to time
+template <typename T1, typename T2>
+void CreateFindCSV(const string& fn, Map<T1, T2>& map);
+
+//Used to compare hash functors. Writes the time per hash
+//followed by the probe length histogram of a HashMap
+//holding the keys
+//fn: The filename
+//keys: The keys to hash
+//n: The number of keys
+template <typename T, typename Hash>
+void CreateHashCSV(const string& fn, const T* keys, unsigned int n);
+
+//Used to compare capacity policies. Writes the time per
+//Put and per Find on HashMaps of each of CAPC_SIZES
+//fn: The filename
+template <typename Capc>
+void CreateCapcCSV(const string& fn);
+
+//Used to time a ConcurrentHashMap from 1 to all hardware
+//threads. Each thread Puts SCALE_OPS distinct keys and then
+//Finds SCALE_OPS keys put by any thread. Writes the number
+//of threads and the Put and Find throughput in ops per ms
+//fn: The filename
+//ns: The number of segments; 1 is a single global lock
+void CreateScaleCSV(const string& fn, unsigned int ns);
+
+//Used to time lock free lookups in an EpochHashMap from 1
+//to all hardware threads while one more thread keeps putting
+//new keys. Each reader Gets SCALE_OPS keys from a map
+//prefilled with SCALE_OPS keys. Writes the number of readers,
+//the read throughput in ops per ms and the number of keys the
+//writer put meanwhile
+//fn: The filename
+void CreateReadScaleCSV(const string& fn);
+
+//Used to compare Find with FindMany on HashMaps of MAP_SIZE
+//to FIND_FILL entries, looking up BATCH_KEYS random keys.
+//Writes the size, the time per key with Find and the time
+//per key with FindMany for each of BATCH_SIZES
+//fn: The filename
+void CreateBatchCSV(const string& fn);
+
+//Used to time each of LAT_PUTS Puts into a HashMap. Writes
+//a histogram of Put latency; line i counts the Puts that took
+//less than 2^i ns and at least 2^(i-1) ns. The last line is
+//the worst Put time in ns
+//fn: The filename
+//inc: True to resize incrementally
+void CreateLatencyCSV(const string& fn, bool inc);
+
+//Used to report the memory use of a map type. The map
+//is grown from MAP_SIZE to FIND_FILL entries; for each size
+//writes the size, the bytes per entry and the time of
+//FindTest. M must provide Bytes()
+//fn: The filename
+template <typename M>
+void CreateBytesCSV(const string& fn);
+
+//Used to compare Find with TryFind when some lookups miss.
+//A map of type M holds MAP_SIZE keys; for miss ratios from 0
+//to 100 percent in steps of 10 writes the ratio, the time per
+//lookup with Find (catching ELE_DNE) and with TryFind
+//fn: The filename
+template <typename M>
+void CreateMissCSV(const string& fn);
+
+//Used to time counter style aggregation. AGG_KEYS random keys
+//below range are counted in a map of type M, once with TryFind
+//followed by Put on a miss and once with FindOrInsert. Writes
+//the time per update of each
+//fn: The filename
+//range: The number of distinct key values
+template <typename M>
+void CreateAggCSV(const string& fn, long range);
+
+//Used to time a BloomMap in front of a map of type M. fill keys
+//are bulk loaded; for miss ratios from 0 to 100 percent in steps
+//of 10 writes the ratio, the time per lookup with TryFind on the
+//map and on the BloomMap and the false positive rate
+//fn: The filename
+//fill: The number of keys in the map
+template <typename M>
+void CreateBloomCSV(const string& fn, long fill);
+
+//Used to compare the SearchTable layouts. For each of
+//LAYOUT_SIZES writes the size and the time per TryFind in
+//each layout
+//fn: The filename
+void CreateLayoutCSV(const string& fn);
+
+//Used to compare one by one and batched updates of a
+//SearchTable. For each of LOAD_SIZES writes the size and the
+//time per pair to load unsorted keys with Put and PutBatch and
+//to remove them with Erase and EraseBatch
+//fn: The filename
+void CreateLoadCSV(const string& fn);
+
+//Used to time ordered range scans. fill even keys are put in a
+//map of type M; for each of SCAN_WIDTHS writes the width, the
+//time per visited pair with Range and with a TryFind on every
+//key in the same ranges. About SCAN_KEYS pairs are visited per
+//width. M must provide Range
+//fn: The filename
+//fill: The number of keys in the map
+template <typename M>
+void CreateScanCSV(const string& fn, long fill);
+
+//Used to compare a PerfectHashMap with a HashMap holding the
+//same keys. For each of PERFECT_SIZES writes the size, the build
+//time per key, the bits of hash function per key, the time per
+//TryFind of each map (half of the lookups miss) and the bytes
+//per entry of each map
+//fn: The filename
+void CreatePerfectCSV(const string& fn);
+
+//Used to time a mix of reads and writes. For write ratios from
+//0 to 100 percent in steps of 10 a map of type M is filled with
+//every other key below range and MIX_OPS random keys below range
+//are either written with Upsert or looked up with TryFind. Writes
+//the ratio and the time per operation
+//fn: The filename
+//range: The number of distinct key values
+template <typename M>
+void CreateMixCSV(const string& fn, long range);
+
+//Used to compare building a SearchTable with mapping a saved
+//one. For each of PERFECT_SIZES writes the size, the time in ms
+//to build the table from unsorted keys, to save it and to map
+//it with a MappedTable and the time per TryFind of each
+//fn: The filename; the table is saved to fn + ".tbl"
+void CreateMappedCSV(const string& fn);
+
+//Used to show how Put and Erase scale with the size of a map
+//of type M. For sizes from MAP_SIZE doubling up to GROWTH_MAX
+//the keys are put in no order and then erased; writes the size
+//and the time per Put and per Erase
+//fn: The filename
+template <typename M>
+void CreateGrowthCSV(const string& fn);
+
+//Used to compare node allocators. For each of ALLOC_SIZES a map
+//of type M is filled with keys in no order, then half of them are
+//erased and as many new keys put. Writes the size, the calls to
+//the system allocator per key and the time per Put after the
+//fill, the time per operation of the churn, the time per pair of
+//a ForEach over the churned map and the time in ms to destroy it
+//fn: The filename
+template <typename M>
+void CreateAllocCSV(const string& fn);
+
 //Used to test the erase function
 //size: The size of the map to test
 //map: The map to test
@@ -57,6 +277,11 @@ long double RunTest(void (*tst)(unsigned int, Map<T1, T2>&), unsigned int numTri
 template <typename T1, typename T2>
 void TestMap(Map<T1, T2>& map);
 
+//Used to test the LEARNED layout of SearchTable on keys with
+//a large gap. Every lookup, bound and insert position must
+//match the SORTED layout; throws ERROR otherwise
+void TestLearned();
+
 //Used to test the size function
 //size: The size of the map to test
 //map: The map to test
@@ -80,7 +305,52 @@ int main2()
 		}
 	}
 	CreateCSV("tm-out.csv", tmmap);
+	CreateMissCSV<TreeMap<long, long double> >("tm-miss.csv");
+	CreateAggCSV<TreeMap<long, long> >("tm-agg.csv", AGG_KEYS);
 	cout << "TreeMap: All tests passed!\n";
+	//Test the AVLMap implementation
+	AVLMap<long, long double> avmap;
+	try
+	{
+		TestMap(avmap);
+	}
+	catch(int error)
+	{
+		if(error == avmap.ELE_DNE)
+		{
+			cout << "AVLMap: A test failed.\n";
+			return -1;
+		}
+	}
+	CreateCSV("avl-out.csv", avmap);
+	CreateMissCSV<AVLMap<long, long double> >("avl-miss.csv");
+	CreateBloomCSV<AVLMap<long, long double> >("avl-bloom.csv", BLOOM_FILL);
+	CreateScanCSV<AVLMap<long, long double> >("avl-scan.csv", BLOOM_FILL);
+	CreateMixCSV<AVLMap<long, long> >("avl-mix.csv", MIX_KEYS);
+	CreateGrowthCSV<AVLMap<long, long> >("avl-growth.csv");
+	CreateAllocCSV<AVLMap<long, long> >("avl-slab.csv");
+	CreateAllocCSV<AVLMap<long, long, HeapAllocator> >("avl-heap.csv");
+	cout << "AVLMap: All tests passed!\n";
+	//Test the BPlusTreeMap implementation
+	BPlusTreeMap<long, long double> bpmap;
+	try
+	{
+		TestMap(bpmap);
+	}
+	catch(int error)
+	{
+		if(error == bpmap.ELE_DNE)
+		{
+			cout << "BPlusTreeMap: A test failed.\n";
+			return -1;
+		}
+	}
+	CreateCSV("bpt-out.csv", bpmap);
+	CreateMissCSV<BPlusTreeMap<long, long double> >("bpt-miss.csv");
+	CreateScanCSV<BPlusTreeMap<long, long double> >("bpt-scan.csv", BLOOM_FILL);
+	CreateMixCSV<BPlusTreeMap<long, long> >("bpt-mix.csv", MIX_KEYS);
+	CreateGrowthCSV<BPlusTreeMap<long, long> >("bpt-growth.csv");
+	cout << "BPlusTreeMap: All tests passed!\n";
 	int i;
 	//Test the HashMap implementation
 	HashMap<long, long double> hmap;
@@ -97,7 +367,90 @@ int main2()
 		}
 	}
 	CreateCSV("hm-out.csv", hmap);
+	CreateEraseCSV("hm-erase.csv", hmap);
+	CreateFindCSV("hm-find.csv", hmap);
 	cout << "HashMap: All tests passed!\n";
+	//Compare the hash functors on random, strided and string keys
+	static long strided[MAP_SIZE];
+	static string strs[MAP_SIZE];
+	for(int j = 0; j < MAP_SIZE; ++j)
+	{
+		strided[j] = 1024L * VALS[j];
+		strs[j] = "session:" + to_string(VALS[j]);
+	}
+	CreateHashCSV<long, MultHash<long> >("hash-mult.csv", VALS, MAP_SIZE);
+	CreateHashCSV<long, DefaultHash<long> >("hash-def.csv", VALS, MAP_SIZE);
+	CreateHashCSV<long, MultHash<long> >("hash-mult-strided.csv", strided, MAP_SIZE);
+	CreateHashCSV<long, DefaultHash<long> >("hash-def-strided.csv", strided, MAP_SIZE);
+	CreateHashCSV<string, DefaultHash<string> >("hash-def-string.csv", strs, MAP_SIZE);
+	//Compare modulo and power of 2 indexing
+	CreateCapcCSV<ModCapacity>("capc-mod.csv");
+	CreateCapcCSV<Pow2Capacity>("capc-pow2.csv");
+	CreateBatchCSV("hm-batch.csv");
+	CreateLatencyCSV("hm-lat.csv", false);
+	CreateLatencyCSV("hm-lat-inc.csv", true);
+	CreateBytesCSV<HashMap<long, long double> >("hm-bytes.csv");
+	CreateMissCSV<HashMap<long, long double> >("hm-miss.csv");
+	CreateAggCSV<HashMap<long, long> >("hm-agg.csv", AGG_KEYS);
+	CreatePerfectCSV("phm-perfect.csv");
+	//Test the SwissMap implementation
+	SwissMap<long, long double> smap;
+	try
+	{
+		TestMap(smap);
+	}
+	catch(int error)
+	{
+		if(error == smap.ELE_DNE)
+		{
+			cout << "SwissMap: A test failed.\n";
+			return -1;
+		}
+	}
+	CreateCSV("sm-out.csv", smap);
+	CreateEraseCSV("sm-erase.csv", smap);
+	CreateFindCSV("sm-find.csv", smap);
+	cout << "SwissMap: All tests passed!\n";
+	//Test the RobinHoodMap implementation
+	RobinHoodMap<long, long double> rmap;
+	try
+	{
+		TestMap(rmap);
+	}
+	catch(int error)
+	{
+		if(error == rmap.ELE_DNE)
+		{
+			cout << "RobinHoodMap: A test failed.\n";
+			return -1;
+		}
+	}
+	CreateCSV("rm-out.csv", rmap);
+	CreateEraseCSV("rm-erase.csv", rmap);
+	CreateFindCSV("rm-find.csv", rmap);
+	cout << "RobinHoodMap: All tests passed!\n";
+	//Test the CuckooMap implementation
+	CuckooMap<long, long double> cmap;
+	try
+	{
+		TestMap(cmap);
+	}
+	catch(int error)
+	{
+		if(error == cmap.ELE_DNE)
+		{
+			cout << "CuckooMap: A test failed.\n";
+			return -1;
+		}
+	}
+	CreateCSV("cm-out.csv", cmap);
+	CreateEraseCSV("cm-erase.csv", cmap);
+	CreateFindCSV("cm-find.csv", cmap);
+	cout << "CuckooMap: All tests passed!\n";
+	//Scaling of one global lock versus lock striping
+	CreateScaleCSV("chm-1-scale.csv", 1);
+	CreateScaleCSV("chm-64-scale.csv", 64);
+	CreateReadScaleCSV("ehm-scale.csv");
 	//cin >> i;
 	//Test the SearchTable implementation
 	SearchTable<long, long double> stmap;
@@ -113,8 +466,43 @@ int main2()
 			return -1;
 		}
 	}
+	try
+	{
+		TestLearned();
+	}
+	catch(int error)
+	{
+		cout << "SearchTable: The LEARNED test failed.\n";
+		return -1;
+	}
 	CreateCSV("st-out.csv", stmap);
+	CreateBytesCSV<SearchTable<long, long double> >("st-bytes.csv");
+	CreateMissCSV<SearchTable<long, long double> >("st-miss.csv");
+	CreateAggCSV<SearchTable<long, long> >("st-agg.csv", MAP_SIZE);
+	CreateBloomCSV<SearchTable<long, long double> >("st-bloom.csv", BLOOM_FILL);
+	CreateLayoutCSV("st-layout.csv");
+	CreateLoadCSV("st-load.csv");
+	CreateScanCSV<SearchTable<long, long double> >("st-scan.csv", BLOOM_FILL);
+	CreateMixCSV<SearchTable<long, long> >("st-mix.csv", MIX_KEYS);
+	CreateMappedCSV("st-mapped.csv");
 	cout << "SearchTable: All tests passed!\n";
+	//Test the LSMMap implementation
+	LSMMap<long, long double> lmap;
+	try
+	{
+		TestMap(lmap);
+	}
+	catch(int error)
+	{
+		if(error == lmap.ELE_DNE)
+		{
+			cout << "LSMMap: A test failed.\n";
+			return -1;
+		}
+	}
+	CreateCSV("lsm-out.csv", lmap);
+	CreateMixCSV<LSMMap<long, long> >("lsm-mix.csv", MIX_KEYS);
+	cout << "LSMMap: All tests passed!\n";
 	cin >> i;
 	//Done; exit with 0 (success)
 	return 0;
@@ -136,6 +524,767 @@ void CreateCSV(const string& fn, Map<T1, T2>& map)
 	csvFile.close();
 }
 
+template <typename T1, typename T2>
+void CreateEraseCSV(const string& fn, Map<T1, T2>& map)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	for(long fill = SPACING; fill <= ERASE_FILL; fill *= 10)
+	{	//Pad the map with keys outside the range of VALS
+		for(long i = 0; i < fill; ++i)
+			map.Put(T1(MAP_SIZE + i), T2(i));
+		PutTest(MAP_SIZE, map);
+		//Time erasing the keys in VALS from the padded map
+		csvFile << fill << ",";
+		csvFile << RunTest(EraseTest<T1, T2>, MAP_SIZE, map) << "\n";
+		for(long i = 0; i < fill; ++i)
+			map.Erase(T1(MAP_SIZE + i));
+	}
+	csvFile.close();
+}
+
+template <typename T1, typename T2>
+void CreateFindCSV(const string& fn, Map<T1, T2>& map)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	long fill = 0;
+	for(long sz = MAP_SIZE; sz <= FIND_FILL; sz *= 10)
+	{	//Grow the map to sz entries; VALS is always a subset
+		for(; fill < sz; ++fill)
+			map.Put(T1(fill), T2(fill));
+		csvFile << sz << ",";
+		csvFile << RunTest(FindTest<T1, T2>, MAP_SIZE, map) << "\n";
+	}
+	for(long i = 0; i < fill; ++i)
+		map.Erase(T1(i));
+	csvFile.close();
+}
+
+template <typename T, typename Hash>
+void CreateHashCSV(const string& fn, const T* keys, unsigned int n)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	//Time the hash function alone
+	Hash hf;
+	uint64 sum = 0;
+	clock_t strt = clock();
+	for(int r = 0; r < HASH_REPS; ++r)
+		for(unsigned int i = 0; i < n; ++i)
+			sum += hf(keys[i]);
+	clock_t end = clock();
+	csvFile << 1000.0 * ((end - strt) / ((long double) HASH_REPS * n * CLOCKS_PER_SEC));
+	//Print the sum so the loop is not optimized away
+	csvFile << "," << sum % 2 << "\n";
+	//Probe lengths in a table at the growth threshold
+	HashMap<T, long, Hash> map(2 * n + 2);
+	for(unsigned int i = 0; i < n; ++i)
+		map.Put(keys[i], i);
+	unsigned int hist[PROBE_LEN];
+	map.ProbeHistogram(hist, PROBE_LEN);
+	for(unsigned int i = 0; i < PROBE_LEN; ++i)
+		csvFile << i << "," << hist[i] << "\n";
+	csvFile.close();
+}
+
+template <typename Capc>
+void CreateCapcCSV(const string& fn)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	for(unsigned int s = 0; s < sizeof(CAPC_SIZES) / sizeof(CAPC_SIZES[0]); ++s)
+	{
+		long size = CAPC_SIZES[s];
+		HashMap<long, long, DefaultHash<long>, Capc> map;
+		csvFile << size << ",";
+		clock_t strt = clock();
+		for(long i = 0; i < size; ++i)
+			map.Put(i, i);
+		clock_t end = clock();
+		csvFile << 1000.0 * ((end - strt) / ((long double) size * CLOCKS_PER_SEC)) << ",";
+		long sum = 0;
+		strt = clock();
+		for(long i = 0; i < size; ++i)
+			sum += map.Find(i);
+		end = clock();
+		csvFile << 1000.0 * ((end - strt) / ((long double) size * CLOCKS_PER_SEC));
+		//Print the sum so the loop is not optimized away
+		csvFile << "," << sum % 2 << "\n";
+	}
+	csvFile.close();
+}
+
+void CreateScaleCSV(const string& fn, unsigned int ns)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	unsigned int maxThreads = thread::hardware_concurrency();
+	if(maxThreads == 0)
+		maxThreads = 1;
+	for(unsigned int nt = 1; nt <= maxThreads; ++nt)
+	{
+		ConcurrentHashMap<long, long> map(ns);
+		thread* ts = new thread[nt];
+		//Put phase; thread t owns keys t, t + nt, ...
+		chrono::steady_clock::time_point strt = chrono::steady_clock::now();
+		for(unsigned int t = 0; t < nt; ++t)
+			ts[t] = thread([&map, t, nt]()
+			{
+				for(long i = 0; i < SCALE_OPS; ++i)
+					map.Put(i * nt + t, i);
+			});
+		for(unsigned int t = 0; t < nt; ++t)
+			ts[t].join();
+		chrono::duration<long double, milli> putTime = chrono::steady_clock::now() - strt;
+		//Find phase; pseudo random keys from all threads
+		strt = chrono::steady_clock::now();
+		for(unsigned int t = 0; t < nt; ++t)
+			ts[t] = thread([&map, t, nt]()
+			{
+				unsigned long long x = t + 1;
+				long v;
+				for(long i = 0; i < SCALE_OPS; ++i)
+				{
+					x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+					map.Get((long) ((x >> 33) % (SCALE_OPS * nt)), v);
+				}
+			});
+		for(unsigned int t = 0; t < nt; ++t)
+			ts[t].join();
+		chrono::duration<long double, milli> findTime = chrono::steady_clock::now() - strt;
+		delete [] ts;
+		csvFile << nt << ",";
+		csvFile << SCALE_OPS * nt / putTime.count() << ",";
+		csvFile << SCALE_OPS * nt / findTime.count() << "\n";
+	}
+	csvFile.close();
+}
+
+void CreateReadScaleCSV(const string& fn)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	unsigned int maxThreads = thread::hardware_concurrency();
+	if(maxThreads == 0)
+		maxThreads = 1;
+	for(unsigned int nt = 1; nt <= maxThreads; ++nt)
+	{
+		EpochHashMap<long, long> map;
+		for(long i = 0; i < SCALE_OPS; ++i)
+			map.Put(i, i);
+		//The writer inserts new keys until the readers finish
+		atomic<bool> done(false);
+		atomic<long> puts(0);
+		thread writer([&map, &done, &puts]()
+		{
+			for(long i = SCALE_OPS; !done.load(); ++i)
+			{
+				map.Put(i, i);
+				puts.store(i - SCALE_OPS + 1);
+			}
+		});
+		thread* ts = new thread[nt];
+		chrono::steady_clock::time_point strt = chrono::steady_clock::now();
+		for(unsigned int t = 0; t < nt; ++t)
+			ts[t] = thread([&map, t]()
+			{
+				EpochHashMap<long, long>::Reader rd(map);
+				unsigned long long x = t + 1;
+				long v;
+				for(long i = 0; i < SCALE_OPS; ++i)
+				{
+					x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+					rd.Get((long) ((x >> 33) % SCALE_OPS), v);
+				}
+			});
+		for(unsigned int t = 0; t < nt; ++t)
+			ts[t].join();
+		chrono::duration<long double, milli> readTime = chrono::steady_clock::now() - strt;
+		done.store(true);
+		writer.join();
+		delete [] ts;
+		csvFile << nt << ",";
+		csvFile << SCALE_OPS * nt / readTime.count() << ",";
+		csvFile << puts.load() << "\n";
+	}
+	csvFile.close();
+}
+
+void CreateBatchCSV(const string& fn)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	//Pseudo random lookup keys, as if from request handlers
+	long* keys = new long[BATCH_KEYS];
+	long** out = new long*[BATCH_KEYS];
+	HashMap<long, long> map;
+	long fill = 0;
+	for(long sz = MAP_SIZE; sz <= FIND_FILL; sz *= 10)
+	{
+		for(; fill < sz; ++fill)
+			map.Put(fill, fill);
+		unsigned long long x = 1;
+		for(long i = 0; i < BATCH_KEYS; ++i)
+		{
+			x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+			keys[i] = (long) ((x >> 33) % sz);
+		}
+		csvFile << sz;
+		long sum = 0;
+		clock_t strt = clock();
+		for(long i = 0; i < BATCH_KEYS; ++i)
+			sum += map.Find(keys[i]);
+		clock_t end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) BATCH_KEYS * CLOCKS_PER_SEC));
+		for(unsigned int b = 0; b < sizeof(BATCH_SIZES) / sizeof(BATCH_SIZES[0]); ++b)
+		{
+			size_t bs = BATCH_SIZES[b];
+			strt = clock();
+			for(size_t i = 0; i < (size_t) BATCH_KEYS; i += bs)
+			{
+				size_t num = BATCH_KEYS - i < bs ? BATCH_KEYS - i : bs;
+				map.FindMany(keys + i, num, out + i);
+				for(size_t j = i; j < i + num; ++j)
+					sum += *out[j];
+			}
+			end = clock();
+			csvFile << "," << 1000.0 * ((end - strt) / ((long double) BATCH_KEYS * CLOCKS_PER_SEC));
+		}
+		//Print the sum so the loops are not optimized away
+		csvFile << "," << sum % 2 << "\n";
+	}
+	delete [] keys;
+	delete [] out;
+	csvFile.close();
+}
+
+void CreateLatencyCSV(const string& fn, bool inc)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	HashMap<long, long> map;
+	map.SetIncremental(inc);
+	unsigned long long hist[LAT_BUCKETS] = {0};
+	long long worst = 0;
+	for(long i = 0; i < LAT_PUTS; ++i)
+	{
+		chrono::steady_clock::time_point strt = chrono::steady_clock::now();
+		map.Put(i, i);
+		long long ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - strt).count();
+		if(ns > worst)
+			worst = ns;
+		unsigned int b = 0;
+		while(b + 1 < LAT_BUCKETS && (1LL << b) <= ns)
+			++b;
+		++hist[b];
+	}
+	for(unsigned int b = 0; b < LAT_BUCKETS; ++b)
+		csvFile << b << "," << hist[b] << "\n";
+	csvFile << worst << "\n";
+	csvFile.close();
+}
+
+template <typename M>
+void CreateBytesCSV(const string& fn)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	M map;
+	long fill = 0;
+	for(long sz = MAP_SIZE; sz <= FIND_FILL; sz *= 10)
+	{	//Grow the map to sz entries; VALS is always a subset
+		for(; fill < sz; ++fill)
+			map.Put(fill, fill);
+		csvFile << sz << ",";
+		csvFile << (double) map.Bytes() / map.Size() << ",";
+		csvFile << RunTest(FindTest<long, long double>, MAP_SIZE, map) << "\n";
+	}
+	csvFile.close();
+}
+
+template <typename M>
+void CreateMissCSV(const string& fn)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	M map;
+	for(int i = 0; i < MAP_SIZE; ++i)
+		map.Put(VALS[i], VALS[i]);
+	long* keys = new long[MISS_KEYS];
+	long double sum = 0;
+	for(int pct = 0; pct <= 100; pct += 10)
+	{	//Keys from MAP_SIZE up are never in the map
+		unsigned long long x = 1;
+		for(long i = 0; i < MISS_KEYS; ++i)
+		{
+			x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+			bool miss = (long) ((x >> 33) % 100) < pct;
+			keys[i] = VALS[i % MAP_SIZE] + (miss ? MAP_SIZE : 0);
+		}
+		csvFile << pct;
+		clock_t strt = clock();
+		for(long i = 0; i < MISS_KEYS; ++i)
+		{
+			try
+			{
+				sum += map.Find(keys[i]);
+			}
+			catch(int)
+			{ }
+		}
+		clock_t end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) MISS_KEYS * CLOCKS_PER_SEC));
+		strt = clock();
+		for(long i = 0; i < MISS_KEYS; ++i)
+		{
+			long double* v = map.TryFind(keys[i]);
+			if(v != NULL)
+				sum += *v;
+		}
+		end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) MISS_KEYS * CLOCKS_PER_SEC));
+		//Print the sum so the loops are not optimized away
+		csvFile << "," << (long) sum % 2 << "\n";
+	}
+	delete [] keys;
+	csvFile.close();
+}
+
+template <typename M>
+void CreateAggCSV(const string& fn, long range)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	long* keys = new long[AGG_KEYS];
+	unsigned long long x = 1;
+	for(long i = 0; i < AGG_KEYS; ++i)
+	{
+		x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+		keys[i] = (long) ((x >> 33) % range);
+	}
+	M m1, m2;
+	clock_t strt = clock();
+	for(long i = 0; i < AGG_KEYS; ++i)
+	{	//Two lookups for every new key
+		long* c = m1.TryFind(keys[i]);
+		if(c != NULL)
+			++*c;
+		else
+			m1.Put(keys[i], 1);
+	}
+	clock_t end = clock();
+	csvFile << 1000.0 * ((end - strt) / ((long double) AGG_KEYS * CLOCKS_PER_SEC)) << ",";
+	strt = clock();
+	for(long i = 0; i < AGG_KEYS; ++i)
+		++m2.FindOrInsert(keys[i]);
+	end = clock();
+	csvFile << 1000.0 * ((end - strt) / ((long double) AGG_KEYS * CLOCKS_PER_SEC));
+	//Print a count so the loops are not optimized away
+	csvFile << "," << m1.Find(keys[0]) + m2.Find(keys[0]) << "\n";
+	delete [] keys;
+	csvFile.close();
+}
+
+template <typename M>
+void CreateBloomCSV(const string& fn, long fill)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	long* keys = new long[BLOOM_FILL];
+	long double* vals = new long double[fill];
+	for(long i = 0; i < fill; ++i)
+	{	//Sorted keys keep the SearchTable load linear
+		keys[i] = 2 * i;
+		vals[i] = i;
+	}
+	M map;
+	BloomMap<long, long double> bm(map, fill);
+	bm.Load(keys, vals, fill);
+	long double sum = 0;
+	for(int pct = 0; pct <= 100; pct += 10)
+	{	//Odd keys fall between the keys in the map
+		unsigned long long x = 1;
+		for(long i = 0; i < BLOOM_FILL; ++i)
+		{
+			x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+			bool miss = (long) ((x >> 33) % 100) < pct;
+			keys[i] = 2 * (long) ((x >> 11) % fill) + (miss ? 1 : 0);
+		}
+		csvFile << pct;
+		clock_t strt = clock();
+		for(long i = 0; i < BLOOM_FILL; ++i)
+		{
+			long double* v = map.TryFind(keys[i]);
+			if(v != NULL)
+				sum += *v;
+		}
+		clock_t end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) BLOOM_FILL * CLOCKS_PER_SEC));
+		bm.ResetStats();
+		strt = clock();
+		for(long i = 0; i < BLOOM_FILL; ++i)
+		{
+			long double* v = bm.TryFind(keys[i]);
+			if(v != NULL)
+				sum += *v;
+		}
+		end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) BLOOM_FILL * CLOCKS_PER_SEC));
+		csvFile << "," << bm.FalsePositiveRate();
+		//Print the sum so the loops are not optimized away
+		csvFile << "," << (long) sum % 2 << "\n";
+	}
+	delete [] keys;
+	delete [] vals;
+	csvFile.close();
+}
+
+void CreateLayoutCSV(const string& fn)
+{
+	typedef SearchTable<long, long> ST;
+	const ST::Layout layouts[] = {ST::SORTED, ST::EYTZINGER, ST::KARY, ST::LEARNED};
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	long* look = new long[LAYOUT_KEYS];
+	long sum = 0;
+	for(unsigned int s = 0; s < sizeof(LAYOUT_SIZES) / sizeof(LAYOUT_SIZES[0]); ++s)
+	{
+		long size = LAYOUT_SIZES[s];
+		long* keys = new long[size];
+		for(long i = 0; i < size; ++i)
+			keys[i] = 2 * i;
+		ST st(keys, keys, size);
+		delete [] keys;
+		unsigned long long x = 1;
+		for(long i = 0; i < LAYOUT_KEYS; ++i)
+		{	//Half of the lookups miss between two keys
+			x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+			look[i] = (long) ((x >> 11) % (2 * size));
+		}
+		csvFile << size;
+		for(unsigned int l = 0; l < sizeof(layouts) / sizeof(layouts[0]); ++l)
+		{
+			st.SetLayout(layouts[l]);
+			clock_t strt = clock();
+			for(long i = 0; i < LAYOUT_KEYS; ++i)
+			{
+				long* v = st.TryFind(look[i]);
+				if(v != NULL)
+					sum += *v;
+			}
+			clock_t end = clock();
+			csvFile << "," << 1000.0 * ((end - strt) / ((long double) LAYOUT_KEYS * CLOCKS_PER_SEC));
+		}
+		//Print the sum so the loops are not optimized away
+		csvFile << "," << sum % 2 << "\n";
+	}
+	delete [] look;
+	csvFile.close();
+}
+
+void CreateLoadCSV(const string& fn)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	for(unsigned int s = 0; s < sizeof(LOAD_SIZES) / sizeof(LOAD_SIZES[0]); ++s)
+	{
+		long size = LOAD_SIZES[s];
+		long* keys = new long[size];
+		for(long i = 0; i < size; ++i)	//Distinct keys in no order
+			keys[i] = (long) ((i * 2654435761ULL) % 4294967311ULL);
+		SearchTable<long, long> st1, st2;
+		csvFile << size;
+		clock_t strt = clock();
+		for(long i = 0; i < size; ++i)
+			st1.Put(keys[i], keys[i]);
+		clock_t end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) size * CLOCKS_PER_SEC));
+		strt = clock();
+		st2.PutBatch(keys, keys, size);
+		end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) size * CLOCKS_PER_SEC));
+		strt = clock();
+		for(long i = 0; i < size; ++i)
+			st1.Erase(keys[i]);
+		end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) size * CLOCKS_PER_SEC));
+		strt = clock();
+		st2.EraseBatch(keys, size);
+		end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) size * CLOCKS_PER_SEC)) << "\n";
+		delete [] keys;
+	}
+	csvFile.close();
+}
+
+template <typename M>
+void CreateScanCSV(const string& fn, long fill)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	M map;
+	for(long i = 0; i < fill; ++i)
+		map.Put(2 * i, (long double) i);
+	long double sum = 0;
+	for(unsigned int w = 0; w < sizeof(SCAN_WIDTHS) / sizeof(SCAN_WIDTHS[0]); ++w)
+	{	//Each range [lo, lo + 2 * width) holds width keys
+		long width = SCAN_WIDTHS[w] < fill ? SCAN_WIDTHS[w] : fill;
+		long scans = SCAN_KEYS / width;
+		long* lo = new long[scans];
+		unsigned long long x = 1;
+		for(long i = 0; i < scans; ++i)
+		{
+			x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+			lo[i] = 2 * (long) ((x >> 11) % (fill - width + 1));
+		}
+		csvFile << width;
+		long visited = 0;
+		clock_t strt = clock();
+		for(long i = 0; i < scans; ++i)
+			visited += map.Range(lo[i], lo[i] + 2 * width,
+				[&sum](const long&, long double& v) { sum += v; });
+		clock_t end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) visited * CLOCKS_PER_SEC));
+		strt = clock();
+		for(long i = 0; i < scans; ++i)
+			for(long k = lo[i]; k < lo[i] + 2 * width; k += 2)
+			{
+				long double* v = map.TryFind(k);
+				if(v != NULL)
+					sum += *v;
+			}
+		end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) visited * CLOCKS_PER_SEC));
+		//Print the sum so the loops are not optimized away
+		csvFile << "," << (long) sum % 2 << "\n";
+		delete [] lo;
+	}
+	csvFile.close();
+}
+
+void CreatePerfectCSV(const string& fn)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	long* look = new long[LAYOUT_KEYS];
+	long sum = 0;
+	for(unsigned int s = 0; s < sizeof(PERFECT_SIZES) / sizeof(PERFECT_SIZES[0]); ++s)
+	{
+		long size = PERFECT_SIZES[s];
+		long* keys = new long[size];
+		for(long i = 0; i < size; ++i)	//Distinct even keys in no order
+			keys[i] = 2 * (long) ((i * 2654435761ULL) % 4294967311ULL);
+		clock_t strt = clock();
+		PerfectHashMap<long, long> pm(keys, keys, size);
+		clock_t end = clock();
+		HashMap<long, long> hm;
+		for(long i = 0; i < size; ++i)
+			hm.Put(keys[i], keys[i]);
+		unsigned long long x = 1;
+		for(long i = 0; i < LAYOUT_KEYS; ++i)
+		{	//Odd keys miss
+			x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+			look[i] = keys[(x >> 11) % size] + (long) ((x >> 5) & 1);
+		}
+		csvFile << size << "," << 1000.0 * ((end - strt) / ((long double) size * CLOCKS_PER_SEC));
+		csvFile << "," << pm.BitsPerKey();
+		strt = clock();
+		for(long i = 0; i < LAYOUT_KEYS; ++i)
+		{
+			long* v = pm.TryFind(look[i]);
+			if(v != NULL)
+				sum += *v;
+		}
+		end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) LAYOUT_KEYS * CLOCKS_PER_SEC));
+		strt = clock();
+		for(long i = 0; i < LAYOUT_KEYS; ++i)
+		{
+			long* v = hm.TryFind(look[i]);
+			if(v != NULL)
+				sum += *v;
+		}
+		end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) LAYOUT_KEYS * CLOCKS_PER_SEC));
+		csvFile << "," << (double) pm.Bytes() / size << "," << (double) hm.Bytes() / size;
+		//Print the sum so the loops are not optimized away
+		csvFile << "," << sum % 2 << "\n";
+		delete [] keys;
+	}
+	delete [] look;
+	csvFile.close();
+}
+
+template <typename M>
+void CreateMixCSV(const string& fn, long range)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	long* keys = new long[MIX_OPS];
+	bool* write = new bool[MIX_OPS];
+	long sum = 0;
+	for(int pct = 0; pct <= 100; pct += 10)
+	{
+		M map;
+		for(long i = 0; i < range; i += 2)
+			map.Put(i, i);
+		unsigned long long x = 1;
+		for(long i = 0; i < MIX_OPS; ++i)
+		{
+			x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+			write[i] = (long) ((x >> 33) % 100) < pct;
+			keys[i] = (long) ((x >> 11) % range);
+		}
+		clock_t strt = clock();
+		for(long i = 0; i < MIX_OPS; ++i)
+		{
+			if(write[i])
+				map.Upsert(keys[i], i);
+			else
+			{
+				long* v = map.TryFind(keys[i]);
+				if(v != NULL)
+					sum += *v;
+			}
+		}
+		clock_t end = clock();
+		csvFile << pct << "," << 1000.0 * ((end - strt) / ((long double) MIX_OPS * CLOCKS_PER_SEC));
+		//Print the sum so the loops are not optimized away
+		csvFile << "," << sum % 2 << "\n";
+	}
+	delete [] keys;
+	delete [] write;
+	csvFile.close();
+}
+
+void CreateMappedCSV(const string& fn)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	string tfn = fn + ".tbl";
+	long* look = new long[LAYOUT_KEYS];
+	long sum = 0;
+	for(unsigned int s = 0; s < sizeof(PERFECT_SIZES) / sizeof(PERFECT_SIZES[0]); ++s)
+	{
+		long size = PERFECT_SIZES[s];
+		long* keys = new long[size];
+		for(long i = 0; i < size; ++i)	//Distinct even keys in no order
+			keys[i] = 2 * (long) ((i * 2654435761ULL) % 4294967311ULL);
+		csvFile << size;
+		clock_t strt = clock();
+		SearchTable<long, long> st(keys, keys, size);
+		clock_t end = clock();
+		csvFile << "," << 1000.0 * (end - strt) / CLOCKS_PER_SEC;
+		strt = clock();
+		MappedTable<long, long>::Write(tfn.c_str(), st);
+		end = clock();
+		csvFile << "," << 1000.0 * (end - strt) / CLOCKS_PER_SEC;
+		strt = clock();
+		MappedTable<long, long> mt(tfn.c_str());
+		end = clock();
+		csvFile << "," << 1000.0 * (end - strt) / CLOCKS_PER_SEC;
+		unsigned long long x = 1;
+		for(long i = 0; i < LAYOUT_KEYS; ++i)
+		{	//Odd keys miss
+			x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+			look[i] = keys[(x >> 11) % size] + (long) ((x >> 5) & 1);
+		}
+		strt = clock();
+		for(long i = 0; i < LAYOUT_KEYS; ++i)
+		{
+			long* v = st.TryFind(look[i]);
+			if(v != NULL)
+				sum += *v;
+		}
+		end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) LAYOUT_KEYS * CLOCKS_PER_SEC));
+		strt = clock();
+		for(long i = 0; i < LAYOUT_KEYS; ++i)
+		{
+			long* v = mt.TryFind(look[i]);
+			if(v != NULL)
+				sum += *v;
+		}
+		end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) LAYOUT_KEYS * CLOCKS_PER_SEC));
+		//Print the sum so the loops are not optimized away
+		csvFile << "," << sum % 2 << "\n";
+		delete [] keys;
+	}
+	remove(tfn.c_str());
+	delete [] look;
+	csvFile.close();
+}
+
+template <typename M>
+void CreateGrowthCSV(const string& fn)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	for(long size = MAP_SIZE; size <= GROWTH_MAX; size *= 2)
+	{
+		long* keys = new long[size];
+		for(long i = 0; i < size; ++i)	//Distinct keys in no order
+			keys[i] = (long) ((i * 2654435761ULL) % 4294967311ULL);
+		M map;
+		clock_t strt = clock();
+		for(long i = 0; i < size; ++i)
+			map.Put(keys[i], i);
+		clock_t end = clock();
+		csvFile << size << "," << 1000.0 * ((end - strt) / ((long double) size * CLOCKS_PER_SEC));
+		strt = clock();
+		for(long i = 0; i < size; ++i)
+			map.Erase(keys[i]);
+		end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) size * CLOCKS_PER_SEC)) << "\n";
+		delete [] keys;
+	}
+	csvFile.close();
+}
+
+template <typename M>
+void CreateAllocCSV(const string& fn)
+{
+	ofstream csvFile;
+	csvFile.open(fn.c_str());
+	for(unsigned int s = 0; s < sizeof(ALLOC_SIZES) / sizeof(ALLOC_SIZES[0]); ++s)
+	{
+		long size = ALLOC_SIZES[s];
+		long* keys = new long[size + size / 2];
+		for(long i = 0; i < size + size / 2; ++i)	//Distinct keys in no order
+			keys[i] = (long) ((i * 2654435761ULL) % 4294967311ULL);
+		M* map = new M();
+		clock_t strt = clock();
+		for(long i = 0; i < size; ++i)
+			map->Put(keys[i], i);
+		clock_t end = clock();
+		csvFile << size << "," << (long double) map->SystemAllocs() / size;
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) size * CLOCKS_PER_SEC));
+		//Free every other node and fill the holes with new keys
+		strt = clock();
+		for(long i = 0; i < size; i += 2)
+			map->Erase(keys[i]);
+		for(long i = size; i < size + size / 2; ++i)
+			map->Put(keys[i], i);
+		end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) size * CLOCKS_PER_SEC));
+		long sum = 0;
+		strt = clock();
+		long visited = map->ForEach([&sum](const long&, long& v) { sum += v; });
+		end = clock();
+		csvFile << "," << 1000.0 * ((end - strt) / ((long double) visited * CLOCKS_PER_SEC));
+		strt = clock();
+		delete map;
+		end = clock();
+		csvFile << "," << 1000.0 * (end - strt) / CLOCKS_PER_SEC;
+		//Print the sum so the loops are not optimized away
+		csvFile << "," << sum % 2 << "\n";
+		delete [] keys;
+	}
+	csvFile.close();
+}
+
 template <typename T1, typename T2>
 void EraseTest(unsigned int size, Map<T1, T2>& map)
 {	
@@ -200,6 +1349,50 @@ void SizeTest(unsigned int size, Map<T1, T2>& map)
 		map.Size();
 }
 
+void TestLearned()
+{
+	typedef SearchTable<long, long> ST;
+	const long GAP = 1000000000000L;
+	long keys[200];
+	for(long i = 0; i < 100; ++i)
+	{	//Two runs of keys far apart
+		keys[i] = i;
+		keys[100 + i] = GAP + i;
+	}
+	ST lst(keys, keys, 200, ST::LEARNED), sst(keys, keys, 200);
+	//Hits, misses in the gap and keys past either end
+	const long probes[] = {-5, 0, 50, 99, 100, 150, 1000, GAP - 1, GAP,
+		GAP + 50, GAP + 99, GAP + 100, 2 * GAP};
+	for(int r = 0; r < 2; ++r)
+	{
+		for(unsigned int i = 0; i < sizeof(probes) / sizeof(probes[0]); ++i)
+		{
+			long lk = -1, sk = -1;
+			long* lv = lst.LowerBound(probes[i], lk);
+			long* sv = sst.LowerBound(probes[i], sk);
+			if((lv == NULL) != (sv == NULL) || lk != sk)
+				throw ERROR;
+			lv = lst.UpperBound(probes[i], lk);
+			sv = sst.UpperBound(probes[i], sk);
+			if((lv == NULL) != (sv == NULL) || lk != sk)
+				throw ERROR;
+			if((lst.TryFind(probes[i]) == NULL) != (sst.TryFind(probes[i]) == NULL))
+				throw ERROR;
+		}
+		//Insert into the gap; both tables must keep the same order
+		lst.Put(150 + r, r);
+		sst.Put(150 + r, r);
+		long order[202];
+		unsigned int j = 0;
+		sst.ForEach([&order, &j](const long& k, long&) { order[j++] = k; });
+		j = 0;
+		bool same = true;
+		lst.ForEach([&order, &j, &same](const long& k, long&) { same = same && order[j++] == k; });
+		if(!same || j != sst.Size())
+			throw ERROR;
+	}
+}
+
 template <typename T1, typename T2>
 void TestMap(Map<T1, T2>& map)
 {